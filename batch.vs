@@ -0,0 +1,22 @@
+#version 430
+
+#ifdef DRAW_PARAMETERS
+#extension GL_ARB_shader_draw_parameters : require
+#define drawID gl_DrawIDARB
+#else
+in uint inDrawID;
+#define drawID inDrawID
+#endif
+
+#include "frame.glsl"
+
+// per-draw model matrices of a batch, indexed by the draw within the multi-draw
+layout(std430, row_major, binding = 2) readonly buffer DrawTransforms {
+    mat4 mMatrices[];
+};
+
+in vec2 inPosition;
+
+void main(void) {
+    gl_Position = pvMatrix * mMatrices[drawID] * vec4(inPosition, 0.0, 1.0);
+}
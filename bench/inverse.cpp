@@ -0,0 +1,165 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+// previous implementation: recursive cofactor expansion
+template<typename T>
+T expansionDeterminant(const Matrix<T, 2, 2> &mat) {
+    return (mat[0][0] * mat[1][1] - mat[1][0] * mat[0][1]);
+}
+
+template<typename T, int n>
+T expansionDeterminant(const Matrix<T, n, n> &mat) {
+    T dst(0);
+
+    for (int j = n - 1; j >= 0; j--) {
+        if ((j % 2) == 0) {
+            dst += mat[0][j] * expansionDeterminant(mat.exclude(0, j));
+        } else {
+            dst -= mat[0][j] * expansionDeterminant(mat.exclude(0, j));
+        }
+    }
+    return dst;
+}
+
+template<typename T, int n>
+Matrix<T, n, n> expansionInverse(const Matrix<T, n, n> &mat) {
+    T data[n][n];
+
+    for (int i = n - 1; i >= 0; i--) {
+        for (int j = n - 1; j >= 0; j--) {
+            if (((i + j) % 2) == 0) {
+                data[i][j] = expansionDeterminant(mat.exclude(i, j));
+            } else {
+                data[i][j] = -expansionDeterminant(mat.exclude(i, j));
+            }
+        }
+    }
+
+    Matrix<T, n, n> dst(data);
+    T det(dst.row(0).dot(mat.row(0)));
+
+    if (!_eq(det, T(0))) {
+        transpose(dst);
+        dst *= T(1) / det;
+    } else {
+        dst = pseudoInverse(mat);
+    }
+    return dst;
+}
+
+
+template<int n>
+Matrix<f32, n, n> randomMatrix() {
+    Matrix<f32, n, n> dst;
+
+    for (int i = n - 1; i >= 0; i--) {
+        for (int j = n - 1; j >= 0; j--) {
+            dst[i][j] = (f32)rand() / (f32)RAND_MAX * 2.0f - 1.0f;
+        }
+        dst[i][i] += (f32)n;
+    }
+    return dst;
+}
+
+template<int n>
+void benchmark(int iterations) {
+    Matrix<f32, n, n> mat(randomMatrix<n>());
+    Matrix<f32, n, n> sink;
+    i64u start;
+    f64 before, after;
+
+    start = Clock::tick();
+    for (int i = 0; i < iterations; i++) {
+        mat[0][0] += 1e-6f;
+        sink += expansionInverse(mat);
+    }
+    before = Clock::elapsed(start) / iterations;
+
+    start = Clock::tick();
+    for (int i = 0; i < iterations; i++) {
+        mat[0][0] += 1e-6f;
+        sink += inverse(mat);
+    }
+    after = Clock::elapsed(start) / iterations;
+
+    printf(
+        "inverse %dx%d: cofactors %10.3f us, current %10.3f us, speedup %8.1fx (%g)\n",
+        n, n,
+        before * 1e6,
+        after * 1e6,
+        before / after,
+        (double)trace(sink)
+    );
+}
+
+// the cofactor inverse in double precision is the reference, the difference
+// is relative to its largest coefficient
+bool accuracy(const char *name, const Matrix<f32, 4, 4> &mat) {
+    Matrix<f64, 4, 4> exact;
+
+    for (int i = 3; i >= 0; i--) {
+        for (int j = 3; j >= 0; j--) {
+            exact[i][j] = mat[i][j];
+        }
+    }
+
+    const Matrix<f64, 4, 4> expected(expansionInverse(exact));
+    const Matrix<f32, 4, 4> actual(inverse(mat));
+    f64 scale = 0.0;
+    f64 error = 0.0;
+
+    for (int i = 3; i >= 0; i--) {
+        for (int j = 3; j >= 0; j--) {
+            scale = _max(scale, _abs(expected[i][j]));
+            error = _max(error, _abs(actual[i][j] - expected[i][j]));
+        }
+    }
+    error /= scale;
+    printf("inverse %-28s: error %10.3g %s\n", name, error, error < 1e-3 ? "ok" : "FAILED");
+    return error < 1e-3;
+}
+
+
+int main(int argc, char **argv) {
+    const Vector<f32, 3> up(Vector3<f32>(0.0f, 1.0f, 0.0f));
+    const Matrix<f32, 4, 4> projection(PerspectiveProjection<f32>(60.0 / 180.0 * M_PI, 16.0f / 9.0f, 0.01f, 100.0f));
+    const Matrix<f32, 4, 4> view(LookAtTransform(Vector3<f32>(300.0f, 120.0f, -450.0f), Vector3<f32>(20.0f, 0.0f, 10.0f), up));
+    bool ok = true;
+
+    Clock::setup();
+    srand(1);
+
+    ok = accuracy("translation 5", TranslateTransform(5.0f, 0.0f, 0.0f)) && ok;
+    ok = accuracy("translation 30", TranslateTransform(30.0f, 0.0f, 0.0f)) && ok;
+    ok = accuracy("translation 100", TranslateTransform(100.0f, -40.0f, 0.0f)) && ok;
+    ok = accuracy("translation 1000", TranslateTransform(1000.0f, 0.0f, -1000.0f)) && ok;
+    ok = accuracy("view", view) && ok;
+    ok = accuracy("projection view", projection * view) && ok;
+
+    benchmark<3>(200000);
+    benchmark<4>(200000);
+    benchmark<8>(20);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+// stands in for a procedural animation
+static f32 animate(i32u i, f64 t) {
+    f32 x = (f32)i;
+
+    for (int j = 0; j < 2000; j++) {
+        x = sinf(x + (f32)t) * 0.5f + cosf(x * 0.25f);
+    }
+    return x;
+}
+
+void benchmark(JobSystem &jobs, i32u count, int iterations) {
+    vector<f32> results(count);
+    i64u start;
+    f64 serial, parallel;
+
+    start = Clock::tick();
+    for (int k = 0; k < iterations; k++) {
+        for (i32u i = 0; i < count; i++) {
+            results[i] = animate(i, k);
+        }
+    }
+    serial = Clock::elapsed(start) / iterations;
+
+    start = Clock::tick();
+    for (int k = 0; k < iterations; k++) {
+        jobs.parallelFor(count, [&results, k] (i32u begin, i32u end) {
+            for (i32u i = begin; i < end; i++) {
+                results[i] = animate(i, k);
+            }
+        }, 64);
+    }
+    parallel = Clock::elapsed(start) / iterations;
+
+    printf(
+        "animate %5u surfaces: serial %10.3f ms, %u workers %10.3f ms, speedup %6.2fx (%g)\n",
+        count,
+        serial * 1e3,
+        jobs.getWorkerCount() + 1,
+        parallel * 1e3,
+        serial / parallel,
+        (double)results[count / 2]
+    );
+}
+
+
+int main(int argc, char **argv) {
+    JobSystem &jobs(JobSystem::shared());
+
+    Clock::setup();
+
+    benchmark(jobs, 100, 50);
+    benchmark(jobs, 1000, 20);
+    benchmark(jobs, 5000, 5);
+    return 0;
+}
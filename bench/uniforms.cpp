@@ -0,0 +1,127 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+static const char *vertexSource =
+    "#version 130\n"
+    "uniform mat4 pMatrix;\n"
+    "uniform mat4 vMatrix;\n"
+    "uniform mat4 pvMatrix;\n"
+    "uniform mat4 pvmMatrix;\n"
+    "in vec2 inPosition;\n"
+    "void main() {\n"
+    "    gl_Position = pvmMatrix * pvMatrix * vMatrix * pMatrix * vec4(inPosition, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *fragmentSource =
+    "#version 130\n"
+    "out vec4 outColor;\n"
+    "void main() {\n"
+    "    outColor = vec4(1.0);\n"
+    "}\n";
+
+
+void benchmark(const shared_ptr<ShaderProgram> &program, int iterations) {
+    Matrix<f32, 4, 4> mat(IdentityTransform<f32>());
+    UniformHandle<Matrix<f32, 4, 4> > pMatrix(program->uniformHandle<Matrix<f32, 4, 4> >("pMatrix"));
+    UniformHandle<Matrix<f32, 4, 4> > vMatrix(program->uniformHandle<Matrix<f32, 4, 4> >("vMatrix"));
+    UniformHandle<Matrix<f32, 4, 4> > pvMatrix(program->uniformHandle<Matrix<f32, 4, 4> >("pvMatrix"));
+    UniformHandle<Matrix<f32, 4, 4> > pvmMatrix(program->uniformHandle<Matrix<f32, 4, 4> >("pvmMatrix"));
+    i64u start;
+    f64 before, after;
+
+    program->enable();
+
+    glFinish();
+    start = Clock::tick();
+    for (int i = 0; i < iterations; i++) {
+        mat[0][0] = (f32)i;
+        program->uniform("pMatrix", mat);
+        program->uniform("vMatrix", mat);
+        program->uniform("pvMatrix", mat);
+        program->uniform("pvmMatrix", mat);
+    }
+    glFinish();
+    before = Clock::elapsed(start) / iterations;
+
+    start = Clock::tick();
+    for (int i = 0; i < iterations; i++) {
+        mat[0][0] = (f32)i;
+        program->uniform(pMatrix, mat);
+        program->uniform(vMatrix, mat);
+        program->uniform(pvMatrix, mat);
+        program->uniform(pvmMatrix, mat);
+    }
+    glFinish();
+    after = Clock::elapsed(start) / iterations;
+
+    program->disable();
+
+    printf(
+        "4x mat4 uniform: by name %10.3f us, by handle %10.3f us, speedup %8.1fx\n",
+        before * 1e6,
+        after * 1e6,
+        before / after
+    );
+}
+
+
+int main(int argc, char **argv) {
+    auto display = XOpenDisplay(getenv("DISPLAY"));
+
+    if (display == NULL) {
+        fprintf(stderr, "ERROR: Invalid display!\n");
+        return 1;
+    }
+    Clock::setup();
+
+    {
+        shared_ptr<GLWindow> window(new GLWindow(display, XScreenOfDisplay(display, 0)));
+
+        if (!window->create() || !window->activate()) {
+            fprintf(stderr, "ERROR: Cannot create window!\n");
+            return 1;
+        }
+        glewInit();
+
+        shared_ptr<ShaderProgram> program(
+            new ShaderProgram(
+                shared_ptr<Shader>(new Shader(GL_VERTEX_SHADER, vertexSource)),
+                shared_ptr<Shader>(new Shader(GL_FRAGMENT_SHADER, fragmentSource))
+            )
+        );
+
+        if (!program->isLinked()) {
+            fprintf(stderr, "ERROR: Cannot link program!\n%s\n", program->getLinkerLogs().c_str());
+            return 1;
+        }
+        benchmark(program, 100000);
+
+        window->deactivate();
+        window->destroy();
+    }
+
+    XCloseDisplay(display);
+    return 0;
+}
@@ -0,0 +1,6 @@
+// per-frame camera constants, filled once per frame by the renderer
+layout(std140, row_major) uniform FrameConstants {
+    mat4 pMatrix;
+    mat4 vMatrix;
+    mat4 pvMatrix;
+};
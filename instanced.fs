@@ -0,0 +1,9 @@
+#version 140
+
+in vec4 color;
+
+out vec4 outColor;
+
+void main(void) {
+    outColor = color;
+}
@@ -0,0 +1,19 @@
+#version 140
+
+#include "frame.glsl"
+#include "surface.glsl"
+
+in vec2 inPosition;
+in vec4 inModelRow0;
+in vec4 inModelRow1;
+in vec4 inModelRow2;
+in vec4 inColor;
+
+out vec4 color;
+
+void main(void) {
+    vec4 position = vec4(inPosition, 0.0, 1.0);
+
+    color = inColor;
+    gl_Position = pvMatrix * mMatrix * vec4(dot(inModelRow0, position), dot(inModelRow1, position), dot(inModelRow2, position), 1.0);
+}
@@ -37,7 +37,7 @@
 #include <errno.h>
 //#include <unistd.h>
 //#include <dirent.h>
-//#include <sys/stat.h>
+#include <sys/stat.h>
 
 #include <X11/X.h>
 //#include <X11/Xlib.h>
@@ -49,14 +49,30 @@
 #include <GL/glxext.h>
 #include <GL/gl.h>
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+#ifdef __SSE3__
+#include <pmmintrin.h>
+#endif
+
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 using namespace std;
@@ -86,18 +102,31 @@ typedef double                  f64;
 // program headers
 #include "math/utils.hpp"
 #include "math/algebra.hpp"
+#include "math/simd.hpp"
 #include "math/transforms.hpp"
+#include "math/quaternion.hpp"
 #include "math/geometry.hpp"
 #include "math/misc.hpp"
 #include "utils/stl.hpp"
 #include "utils/clock.hpp"
+#include "utils/jobs.hpp"
+#include "utils/state.hpp"
 #include "utils/buffer.hpp"
 #include "utils/texture.hpp"
 #include "utils/shader.hpp"
+#include "utils/format.hpp"
+#include "utils/arena.hpp"
+#include "utils/block.hpp"
+#include "utils/preprocessor.hpp"
+#include "utils/cache.hpp"
+#include "utils/readback.hpp"
 #include "scene/camera.hpp"
 #include "scene/renderer.hpp"
 #include "scene/window.hpp"
+#include "scene/batch.hpp"
+#include "scene/queue.hpp"
 #include "scene/surface.hpp"
+#include "scene/registry.hpp"
 #include "scene/scene.hpp"
 
 
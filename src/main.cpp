@@ -47,18 +47,33 @@ void run(Display *display, Screen *screen) {
     );
 
     // setup demo scene
+    shared_ptr<ProgramCache> programCache(new ProgramCache());
+    ShaderVariantCache shaders(programCache);
     shared_ptr<ShaderProgram> program(
-        new ShaderProgram(
-            Shader::fromFile(GL_VERTEX_SHADER, "test.vs"),
-            Shader::fromFile(GL_FRAGMENT_SHADER, "test.fs")
-        )
+        DrawBatcher::supported() ?
+        shaders.program("batch.vs", "test.fs", DrawBatcher::defines(), true) :
+        shaders.program("test.vs", "test.fs", ShaderPreprocessor::Defines(), true)
     );
+
+    program->setShadowing(true);
     shared_ptr<Surface> surface0(new FlatSurface(program));
+    shared_ptr<ShaderProgram> instancedProgram(shaders.program("instanced.vs", "instanced.fs", ShaderPreprocessor::Defines(), true));
+    shared_ptr<InstancedSurface> tiles(new InstancedSurface(instancedProgram, 64 * 64));
     Scene scene;
 
+    for (i32 y = 0; y < 64; y++) {
+        for (i32 x = 0; x < 64; x++) {
+            tiles->addInstance(
+                TranslateAffine<f32>((x - 31.5) * 0.05, (y - 31.5) * 0.05, -2) * ScaleAffine<f32>(0.04, 0.04, 1),
+                Vector4<i8u>(x * 4, y * 4, 128, 255)
+            );
+        }
+    }
+
     // program->print();
 
     scene.addSurface("surface0", surface0);
+    scene.addSurface("tiles", tiles);
     scene.startAll();
     scene.showAll();
 
@@ -73,10 +88,10 @@ void run(Display *display, Screen *screen) {
 
         if (draw) {
             window->camera.viewport = Rectangle2<i32>(0, 0, window->width(), window->height());
-            window->camera = window->camera.withProjectionMatrix(
+            window->camera.setProjectionMatrix(
                 PerspectiveProjection<f32>(60.0 / 180.0 * M_PI, window->ratio(), 0.01, 100.0)
             );
-            // .withViewMatrix(
+            // window->camera.setViewMatrix(
             //  LookAroundYTransform<f32>(Vector3<f32>(0, 0, 0), 10.0, Clock::elapsed(firstDraw) * M_PI * 2, 0)
             // );
             // renderer.animate();
@@ -86,6 +101,7 @@ void run(Display *display, Screen *screen) {
 
             scene.animate();
             scene.render(window);
+            programCache->update();
         }
         while (XPending(display)) {
             XEvent xev;
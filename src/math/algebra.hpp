@@ -24,15 +24,24 @@
 #define __MATH_ALGEBRA_H_INCLUDE__
 
 
+// vectors whose footprint is a multiple of 16 bytes are aligned for SSE
+// loads, all others keep the alignment of their element type so arrays of
+// them stay tightly packed.
+template<typename T, int n>
+struct VectorAlignment {
+    static const int value = ((sizeof(T) * n) % 16) == 0 ? 16 : alignof(T);
+};
+
+
 template<typename T, int n>
 class Vector {
 protected:
-    T data[n];
+    alignas(VectorAlignment<T, n>::value) T data[n];
 
 
 public:
-    const int size = n;
-    const int cols = n;
+    static const int size = n;
+    static const int cols = n;
 
 
     inline Vector() {
@@ -47,11 +56,7 @@ public:
         }
     }
 
-    inline Vector(const Vector<T, n> &vec) {
-        for (int i = n - 1; i >= 0; i--) {
-            this->data[i] = vec[i];
-        }
-    }
+    Vector(const Vector<T, n> &vec) = default;
 
     template<int n2>
     Vector(const Vector<T, n2> &vec) {
@@ -64,12 +69,7 @@ public:
     }
 
 
-    Vector<T, n> & operator =(const Vector<T, n> &vec) {
-        for (int i = n - 1; i >= 0; i--) {
-            this->data[i] = vec[i];
-        }
-        return *this;
-    }
+    Vector<T, n> & operator =(const Vector<T, n> &vec) = default;
 
     template<int n2>
     Vector<T, n> & operator =(const Vector<T, n2> &vec) {
@@ -376,10 +376,10 @@ protected:
 
 
 public:
-    const int size = m * n;
-    const int bits = ((size % 8) == 0 ? (size >> 3) : ((size + (8 - size % 8)) >> 3));
-    const int rows = m;
-    const int cols = n;
+    static const int size = m * n;
+    static const int bits = ((size % 8) == 0 ? (size >> 3) : ((size + (8 - size % 8)) >> 3));
+    static const int rows = m;
+    static const int cols = n;
 
 
     inline Matrix() {
@@ -399,11 +399,7 @@ public:
         }
     }
 
-    inline Matrix(const Matrix<T, m, n> &mat) {
-        for (int i = m - 1; i >= 0; i--) {
-            this->data[i] = mat[i];
-        }
-    }
+    Matrix(const Matrix<T, m, n> &mat) = default;
 
     template<int m2, int n2>
     Matrix(const Matrix<T, m2, n2> &mat) {
@@ -413,12 +409,7 @@ public:
     }
 
 
-    Matrix<T, m, n> & operator =(const Matrix<T, m, n> &mat) {
-        for (int i = m - 1; i >= 0; i--) {
-            this->data[i] = mat[i];
-        }
-        return *this;
-    }
+    Matrix<T, m, n> & operator =(const Matrix<T, m, n> &mat) = default;
 
     template<int m2, int n2>
     Matrix<T, m, n> & operator =(const Matrix<T, m2, n2> &mat) {
@@ -432,6 +423,11 @@ public:
     }
 
 
+    inline operator const T * () const {
+        return this->data[0];
+    }
+
+
     inline Vector<T, n> & operator [] (int i) {
         return this->data[i];
     }
@@ -778,9 +774,9 @@ inline Matrix<T, 4, 4> Matrix4x4(const T &m11, const T &m12, const T &m13, const
 
 template<typename T, int n>
 void transpose(Matrix<T, n, n> &mat) {
-    unsigned char flags[mat.bits];
+    unsigned char flags[Matrix<T, n, n>::bits];
 
-    for (int i = mat.bits - 1; i >= 0; i--) {
+    for (int i = Matrix<T, n, n>::bits - 1; i >= 0; i--) {
         flags[i] = 0;
     }
     for (int i = n - 1; i >= 0; i--) {
@@ -815,6 +811,101 @@ T trace(const Matrix<T, n, n> &mat) {
     return dst;
 }
 
+template<typename T, int n>
+bool lu(const Matrix<T, n, n> &mat, Matrix<T, n, n> &decomposition, int pivots[n], int &swaps) {
+    T scale(0);
+
+    decomposition = mat;
+    swaps = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        pivots[i] = i;
+        for (int j = n - 1; j >= 0; j--) {
+            scale = _max(scale, _abs(mat[i][j]));
+        }
+    }
+
+    const T tolerance(_eps<T>(T(10 * n)) * scale);
+
+    for (int k = 0; k < n; k++) {
+        T maximum(_abs(decomposition[k][k]));
+        int p = k;
+
+        for (int i = k + 1; i < n; i++) {
+            if (_abs(decomposition[i][k]) > maximum) {
+                maximum = _abs(decomposition[i][k]);
+                p = i;
+            }
+        }
+        if (maximum <= tolerance) {
+            return false;
+        }
+        if (p != k) {
+            const Vector<T, n> row(decomposition[k]);
+            const int pivot = pivots[k];
+
+            decomposition[k] = decomposition[p];
+            decomposition[p] = row;
+            pivots[k] = pivots[p];
+            pivots[p] = pivot;
+            swaps++;
+        }
+
+        const T pivotInverse(T(1) / decomposition[k][k]);
+
+        for (int i = k + 1; i < n; i++) {
+            const T factor(decomposition[i][k] * pivotInverse);
+
+            decomposition[i][k] = factor;
+            for (int j = k + 1; j < n; j++) {
+                decomposition[i][j] -= factor * decomposition[k][j];
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T, int n>
+inline bool lu(const Matrix<T, n, n> &mat, Matrix<T, n, n> &decomposition, int pivots[n]) {
+    int swaps = 0;
+
+    return lu(mat, decomposition, pivots, swaps);
+}
+
+template<typename T, int n>
+Vector<T, n> solve(const Matrix<T, n, n> &decomposition, const int pivots[n], const Vector<T, n> &b) {
+    Vector<T, n> x;
+
+    for (int i = 0; i < n; i++) {
+        T value(b[pivots[i]]);
+
+        for (int j = 0; j < i; j++) {
+            value -= decomposition[i][j] * x[j];
+        }
+        x[i] = value;
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        T value(x[i]);
+
+        for (int j = i + 1; j < n; j++) {
+            value -= decomposition[i][j] * x[j];
+        }
+        x[i] = value / decomposition[i][i];
+    }
+    return x;
+}
+
+template<typename T, int n>
+bool solve(const Matrix<T, n, n> &mat, const Vector<T, n> &b, Vector<T, n> &x) {
+    Matrix<T, n, n> decomposition;
+    int pivots[n];
+
+    if (!lu(mat, decomposition, pivots)) {
+        return false;
+    }
+    x = solve(decomposition, pivots, b);
+    return true;
+}
+
 template<typename T, int n>
 Matrix<T, n, n> cofactors(const Matrix<T, n, n> &mat) {
     T data[n][n];
@@ -838,7 +929,20 @@ T determinant(const Matrix<T, 2, 2> &mat) {
 
 template<typename T, int n>
 T determinant(const Matrix<T, n, n> &mat) {
-    return cofactors(mat).row(0).dot(mat.row(0));
+    Matrix<T, n, n> decomposition;
+    int pivots[n];
+    int swaps = 0;
+
+    if (!lu(mat, decomposition, pivots, swaps)) {
+        return T(0);
+    }
+
+    T dst((swaps % 2) == 0 ? T(1) : T(-1));
+
+    for (int i = n - 1; i >= 0; i--) {
+        dst *= decomposition[i][i];
+    }
+    return dst;
 }
 
 template<typename T, int m, int n>
@@ -968,27 +1072,38 @@ void svd(const Matrix<T, n, n> &mat, Matrix<T, n, n> &u, Matrix<T, n, n> &s, Mat
     }
 }
 
+template<typename T, int n>
+Matrix<T, n, n> pseudoInverse(const Matrix<T, n, n> &mat) {
+    Matrix<T, n, n> u, s, v;
+
+    svd(mat, u, s, v);
+    for (int i = n - 1; i >= 0; i--) {
+        if (_ne0(s[i][i])) {
+            s[i][i] = T(1) / s[i][i];
+        } else {
+            s[i][i] = T(0);
+        }
+    }
+    transpose(v);
+    return u * s * v;
+}
+
 template<typename T, int n>
 Matrix<T, n, n> inverse(const Matrix<T, n, n> &mat) {
-    Matrix<T, n, n> dst(cofactors(mat));
-    T det(dst.row(0).dot(mat.row(0)));
+    Matrix<T, n, n> decomposition;
+    int pivots[n];
 
-    if (!_eq(det, T(0))) {
-        transpose(dst);
-        dst *= T(1) / det;
-    } else {
-        Matrix<T, n, n> u, s, v;
+    if (!lu(mat, decomposition, pivots)) {
+        return pseudoInverse(mat);
+    }
 
-        svd(mat, u, s, v);
-        for (int i = n - 1; i >= 0; i--) {
-            if (_ne0(s[i][i])) {
-                s[i][i] = T(1) / s[i][i];
-            } else {
-                s[i][i] = T(0);
-            }
-        }
-        transpose(v);
-        dst = u * s * v;
+    Matrix<T, n, n> dst;
+
+    for (int j = n - 1; j >= 0; j--) {
+        Vector<T, n> e;
+
+        e[j] = T(1);
+        dst.col(j, solve(decomposition, pivots, e));
     }
     return dst;
 }
@@ -45,8 +45,10 @@ public:
     inline Rectangle2(const V &tl, const V &br) : _tl(Vector2(_min(tl[0], br[0]), _min(tl[1], br[1]))), _br(Vector2(_max(tl[0], br[0]), _max(tl[1], br[1]))) {
     }
 
-    inline Rectangle2(const Rectangle2<T> &rect) : _tl(rect._tl), _br(rect._br) {
-    }
+    Rectangle2(const Rectangle2<T> &rect) = default;
+
+
+    Rectangle2<T> & operator =(const Rectangle2<T> &rect) = default;
 
 
     int operator ==(const Rectangle2<T> &rect) const {
@@ -122,8 +124,10 @@ public:
     inline Line(const V &point, const V &direction) : _point(point), _direction(direction) {
     }
 
-    inline Line(const Line<T, n> &line) : _point(line._point), _direction(line._direction) {
-    }
+    Line(const Line<T, n> &line) = default;
+
+
+    Line<T, n> & operator =(const Line<T, n> &line) = default;
 
 
     int operator ==(const Line<T, n> &line) const {
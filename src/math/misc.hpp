@@ -38,15 +38,10 @@ public:
     inline Range(const T &minimum, const T &maximum) : _minimum(minimum), _maximum(maximum) {
     }
 
-    inline Range(const Range<T> &range) : _minimum(range._minimum), _maximum(range._maximum) {
-    }
+    Range(const Range<T> &range) = default;
 
 
-    Range<T> & operator =(const Range<T> &range) {
-        this->_minimum = range._minimum;
-        this->_maximum = range._maximum;
-        return *this;
-    }
+    Range<T> & operator =(const Range<T> &range) = default;
 
 
     int operator ==(const Range<T> &range) const {
@@ -103,16 +98,10 @@ public:
     inline RGB(const T &r, const T &g, const T &b) : _r(r), _g(g), _b(b) {
     }
 
-    inline RGB(const RGB<T> &color) : _r(color._r), _g(color._g), _b(color._b) {
-    }
+    RGB(const RGB<T> &color) = default;
 
 
-    RGB<T> & operator =(const RGB<T> &color) {
-        this->_r = color._r;
-        this->_g = color._g;
-        this->_b = color._b;
-        return *this;
-    }
+    RGB<T> & operator =(const RGB<T> &color) = default;
 
 
     int operator ==(const RGB<T> &color) const {
@@ -165,17 +154,10 @@ public:
     inline RGBA(const T &r, const T &g, const T &b, const T &a) : _r(r), _g(g), _b(b), _a(a) {
     }
 
-    inline RGBA(const RGBA<T> &color) : _r(color._r), _g(color._g), _b(color._b), _a(color._a) {
-    }
+    RGBA(const RGBA<T> &color) = default;
 
 
-    RGBA<T> & operator =(const RGBA<T> &color) {
-        this->_r = color._r;
-        this->_g = color._g;
-        this->_b = color._b;
-        this->_a = color._a;
-        return *this;
-    }
+    RGBA<T> & operator =(const RGBA<T> &color) = default;
 
 
     int operator ==(const RGBA<T> &color) const {
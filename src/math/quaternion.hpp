@@ -0,0 +1,370 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __MATH_QUATERNION_H_INCLUDE__
+#define __MATH_QUATERNION_H_INCLUDE__
+
+
+// rotation quaternion stored as [ x y z w ], w being the scalar part
+template<typename T>
+class Quaternion {
+public:
+    typedef Vector<T, 3> V;
+
+
+protected:
+    Vector<T, 4> data;
+
+
+public:
+    inline Quaternion() : data(Vector4<T>(T(0), T(0), T(0), T(1))) {
+    }
+
+    inline Quaternion(const T &x, const T &y, const T &z, const T &w) : data(Vector4<T>(x, y, z, w)) {
+    }
+
+    inline Quaternion(const Vector<T, 4> &vec) : data(vec) {
+    }
+
+    explicit inline Quaternion(const Matrix<T, 3, 3> &mat) {
+        this->setRotation(mat);
+    }
+
+    explicit inline Quaternion(const Matrix<T, 4, 4> &mat) {
+        this->setRotation(mat);
+    }
+
+    explicit inline Quaternion(const Affine3<T> &affine) {
+        this->setRotation(affine);
+    }
+
+    Quaternion(const Quaternion<T> &q) = default;
+
+
+    Quaternion<T> & operator =(const Quaternion<T> &q) = default;
+
+
+    inline int operator ==(const Quaternion<T> &q) const {
+        return this->data == q.data;
+    }
+
+    inline int operator !=(const Quaternion<T> &q) const {
+        return !(*this == q);
+    }
+
+
+    inline const T & x() const {
+        return this->data[0];
+    }
+
+    inline const T & y() const {
+        return this->data[1];
+    }
+
+    inline const T & z() const {
+        return this->data[2];
+    }
+
+    inline const T & w() const {
+        return this->data[3];
+    }
+
+    inline V vector() const {
+        return V(this->data);
+    }
+
+    inline const Vector<T, 4> & coefficients() const {
+        return this->data;
+    }
+
+
+    inline Quaternion<T> operator -() const {
+        return Quaternion<T>(-this->data);
+    }
+
+    inline Quaternion<T> operator + (const Quaternion<T> &q) const {
+        return Quaternion<T>(this->data + q.data);
+    }
+
+    inline Quaternion<T> operator - (const Quaternion<T> &q) const {
+        return Quaternion<T>(this->data - q.data);
+    }
+
+    inline Quaternion<T> operator * (const T &scalar) const {
+        return Quaternion<T>(this->data * scalar);
+    }
+
+    // Hamilton product, applies q first then this
+    Quaternion<T> operator * (const Quaternion<T> &q) const {
+        const T &x1(this->data[0]), &y1(this->data[1]), &z1(this->data[2]), &w1(this->data[3]);
+        const T &x2(q.data[0]), &y2(q.data[1]), &z2(q.data[2]), &w2(q.data[3]);
+
+        return Quaternion<T>(
+            w1 * x2 + x1 * w2 + y1 * z2 - z1 * y2,
+            w1 * y2 - x1 * z2 + y1 * w2 + z1 * x2,
+            w1 * z2 + x1 * y2 - y1 * x2 + z1 * w2,
+            w1 * w2 - x1 * x2 - y1 * y2 - z1 * z2
+        );
+    }
+
+    inline Quaternion<T> & operator *= (const Quaternion<T> &q) {
+        *this = *this * q;
+        return *this;
+    }
+
+
+    inline T dot(const Quaternion<T> &q) const {
+        return this->data.dot(q.data);
+    }
+
+    inline T length() const {
+        return _sqrt(this->data.dot(this->data));
+    }
+
+
+    // v' = v + 2w (u x v) + 2 u x (u x v), expects a unit quaternion
+    V rotate(const V &vec) const {
+        const V u(this->data);
+        const V t(cross(u, vec) * T(2));
+
+        return vec + t * this->data[3] + cross(u, t);
+    }
+
+    void rotate(const V *src, V *dst, i32u count) const {
+        for (i32u i = 0; i < count; i++) {
+            dst[i] = this->rotate(src[i]);
+        }
+    }
+
+
+    Matrix<T, 3, 3> matrix3() const {
+        const T &x(this->data[0]), &y(this->data[1]), &z(this->data[2]), &w(this->data[3]);
+        const T x2(x + x), y2(y + y), z2(z + z);
+        const T xx(x * x2), yy(y * y2), zz(z * z2);
+        const T xy(x * y2), xz(x * z2), yz(y * z2);
+        const T wx(w * x2), wy(w * y2), wz(w * z2);
+
+        return Matrix3x3<T>(
+            T(1) - (yy + zz),         xy - wz,          xz + wy,
+                     xy + wz,  T(1) - (xx + zz),         yz - wx,
+                     xz - wy,          yz + wx,  T(1) - (xx + yy)
+        );
+    }
+
+    inline Matrix<T, 4, 4> matrix() const {
+        return this->affine().matrix();
+    }
+
+    inline Affine3<T> affine(const V &translation = V()) const {
+        return Affine3<T>(this->matrix3(), translation);
+    }
+
+
+    // Shepperd's method, picks the largest diagonal term to stay well conditioned
+    template<typename M>
+    void setRotation(const M &mat) {
+        const T trace(mat[0][0] + mat[1][1] + mat[2][2]);
+
+        if (trace > T(0)) {
+            const T s(_sqrt(trace + T(1)) * T(2));
+
+            this->data = Vector4<T>((mat[2][1] - mat[1][2]) / s, (mat[0][2] - mat[2][0]) / s, (mat[1][0] - mat[0][1]) / s, s / T(4));
+        } else if (mat[0][0] > mat[1][1] && mat[0][0] > mat[2][2]) {
+            const T s(_sqrt(T(1) + mat[0][0] - mat[1][1] - mat[2][2]) * T(2));
+
+            this->data = Vector4<T>(s / T(4), (mat[0][1] + mat[1][0]) / s, (mat[0][2] + mat[2][0]) / s, (mat[2][1] - mat[1][2]) / s);
+        } else if (mat[1][1] > mat[2][2]) {
+            const T s(_sqrt(T(1) + mat[1][1] - mat[0][0] - mat[2][2]) * T(2));
+
+            this->data = Vector4<T>((mat[0][1] + mat[1][0]) / s, s / T(4), (mat[1][2] + mat[2][1]) / s, (mat[0][2] - mat[2][0]) / s);
+        } else {
+            const T s(_sqrt(T(1) + mat[2][2] - mat[0][0] - mat[1][1]) * T(2));
+
+            this->data = Vector4<T>((mat[0][2] + mat[2][0]) / s, (mat[1][2] + mat[2][1]) / s, s / T(4), (mat[1][0] - mat[0][1]) / s);
+        }
+    }
+
+
+    void print(const char *name) const {
+        printf("%s\n", name);
+        this->print();
+        printf("\n");
+    }
+
+    void print() const {
+        printf("Quaternion: %.05f %.05f %.05f %.05f\n", (double)this->data[0], (double)this->data[1], (double)this->data[2], (double)this->data[3]);
+    }
+};
+
+
+template<typename T>
+Quaternion<T> normalize(const Quaternion<T> &q) {
+    const T length(q.length());
+
+    if (_ne0(length)) {
+        return q * (T(1) / length);
+    }
+    return Quaternion<T>();
+}
+
+template<typename T>
+inline Quaternion<T> conjugate(const Quaternion<T> &q) {
+    return Quaternion<T>(-q.x(), -q.y(), -q.z(), q.w());
+}
+
+template<typename T>
+Quaternion<T> inverse(const Quaternion<T> &q) {
+    const T length2(q.dot(q));
+
+    if (_ne0(length2)) {
+        return conjugate(q) * (T(1) / length2);
+    }
+    return Quaternion<T>();
+}
+
+
+// both interpolations take the shortest arc between a and b
+template<typename T>
+Quaternion<T> nlerp(const Quaternion<T> &a, const Quaternion<T> &b, const T &t) {
+    const T sign(a.dot(b) < T(0) ? T(-1) : T(1));
+
+    return normalize(a * (T(1) - t) + b * (sign * t));
+}
+
+template<typename T>
+Quaternion<T> slerp(const Quaternion<T> &a, const Quaternion<T> &b, const T &t) {
+    T cosTheta(a.dot(b));
+    T sign(T(1));
+
+    if (cosTheta < T(0)) {
+        cosTheta = -cosTheta;
+        sign = T(-1);
+    }
+    if (cosTheta > T(0.9995)) {
+        return normalize(a * (T(1) - t) + b * (sign * t));
+    }
+
+    const T theta(_acos(cosTheta));
+    const T sinThetaInverse(T(1) / _sin(theta));
+
+    return a * (_sin((T(1) - t) * theta) * sinThetaInverse) + b * (sign * _sin(t * theta) * sinThetaInverse);
+}
+
+
+template<typename T>
+void nlerp(const Quaternion<T> *a, const Quaternion<T> *b, const T &t, Quaternion<T> *dst, i32u count) {
+    for (i32u i = 0; i < count; i++) {
+        dst[i] = nlerp(a[i], b[i], t);
+    }
+}
+
+template<typename T>
+void slerp(const Quaternion<T> *a, const Quaternion<T> *b, const T &t, Quaternion<T> *dst, i32u count) {
+    for (i32u i = 0; i < count; i++) {
+        dst[i] = slerp(a[i], b[i], t);
+    }
+}
+
+template<typename T>
+inline void nlerp(const vector< Quaternion<T> > &a, const vector< Quaternion<T> > &b, const T &t, vector< Quaternion<T> > &dst) {
+    dst.resize(_min(a.size(), b.size()));
+    nlerp(a.data(), b.data(), t, dst.data(), dst.size());
+}
+
+template<typename T>
+inline void slerp(const vector< Quaternion<T> > &a, const vector< Quaternion<T> > &b, const T &t, vector< Quaternion<T> > &dst) {
+    dst.resize(_min(a.size(), b.size()));
+    slerp(a.data(), b.data(), t, dst.data(), dst.size());
+}
+
+
+template<typename T>
+void convert(const Quaternion<T> *src, Matrix<T, 3, 3> *dst, i32u count) {
+    for (i32u i = 0; i < count; i++) {
+        dst[i] = src[i].matrix3();
+    }
+}
+
+template<typename T>
+void convert(const Quaternion<T> *src, Matrix<T, 4, 4> *dst, i32u count) {
+    for (i32u i = 0; i < count; i++) {
+        dst[i] = src[i].matrix();
+    }
+}
+
+// keeps the translation already stored in dst
+template<typename T>
+void convert(const Quaternion<T> *src, Affine3<T> *dst, i32u count) {
+    for (i32u i = 0; i < count; i++) {
+        dst[i] = Affine3<T>(src[i].matrix3(), dst[i].translation());
+    }
+}
+
+template<typename T, typename M>
+void convert(const M *src, Quaternion<T> *dst, i32u count) {
+    for (i32u i = 0; i < count; i++) {
+        dst[i].setRotation(src[i]);
+    }
+}
+
+template<typename S, typename D>
+inline void convert(const vector<S> &src, vector<D> &dst) {
+    dst.resize(src.size());
+    convert(src.data(), dst.data(), src.size());
+}
+
+
+template<typename T>
+inline Quaternion<T> IdentityQuaternion() {
+    return Quaternion<T>();
+}
+
+template<typename T>
+inline Quaternion<T> RotateQuaternion(const T &angle, const T &x, const T &y, const T &z) {
+    const Vector<T, 3> axis(normalize(Vector3<T>(x, y, z)));
+    const T s(_sin(angle / T(2)));
+
+    return Quaternion<T>(axis[0] * s, axis[1] * s, axis[2] * s, _cos(angle / T(2)));
+}
+
+template<typename T>
+inline Quaternion<T> RotateQuaternion(const T &angle, const Vector<T, 3> &axis) {
+    return RotateQuaternion(angle, axis[0], axis[1], axis[2]);
+}
+
+template<typename T>
+inline Quaternion<T> RotateXQuaternion(const T &angle) {
+    return Quaternion<T>(_sin(angle / T(2)), T(0), T(0), _cos(angle / T(2)));
+}
+
+template<typename T>
+inline Quaternion<T> RotateYQuaternion(const T &angle) {
+    return Quaternion<T>(T(0), _sin(angle / T(2)), T(0), _cos(angle / T(2)));
+}
+
+template<typename T>
+inline Quaternion<T> RotateZQuaternion(const T &angle) {
+    return Quaternion<T>(T(0), T(0), _sin(angle / T(2)), _cos(angle / T(2)));
+}
+
+
+#endif //__MATH_QUATERNION_H_INCLUDE__
@@ -0,0 +1,255 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __MATH_SIMD_H_INCLUDE__
+#define __MATH_SIMD_H_INCLUDE__
+
+
+// SSE specializations of the hot f32 4x4 kernels, the generic templates in
+// algebra.hpp remain the fallback when the compiler does not target SSE.
+#ifdef __SSE__
+
+
+static_assert(alignof(Vector<f32, 4>) == 16, "Vector<f32, 4> rows must be 16-byte aligned");
+
+
+inline __m128 _load4(const Vector<f32, 4> &vec) {
+    return _mm_load_ps(&vec[0]);
+}
+
+inline void _store4(Vector<f32, 4> &vec, __m128 value) {
+    _mm_store_ps(&vec[0], value);
+}
+
+
+#ifdef __SSE3__
+template<>
+inline f32 Vector<f32, 4>::dot(const Vector<f32, 4> &vec) const {
+    __m128 value = _mm_mul_ps(_mm_load_ps(this->data), _load4(vec));
+
+    value = _mm_hadd_ps(value, value);
+    value = _mm_hadd_ps(value, value);
+    return _mm_cvtss_f32(value);
+}
+
+template<>
+inline Vector<f32, 4> Matrix<f32, 4, 4>::operator * (const Vector<f32, 4> &v) const {
+    Vector<f32, 4> dst;
+    __m128 vec = _load4(v);
+    __m128 r0 = _mm_mul_ps(_load4(this->data[0]), vec);
+    __m128 r1 = _mm_mul_ps(_load4(this->data[1]), vec);
+    __m128 r2 = _mm_mul_ps(_load4(this->data[2]), vec);
+    __m128 r3 = _mm_mul_ps(_load4(this->data[3]), vec);
+
+    _store4(dst, _mm_hadd_ps(_mm_hadd_ps(r0, r1), _mm_hadd_ps(r2, r3)));
+    return dst;
+}
+#else
+template<>
+inline Vector<f32, 4> Matrix<f32, 4, 4>::operator * (const Vector<f32, 4> &v) const {
+    Vector<f32, 4> dst;
+    __m128 r0 = _load4(this->data[0]);
+    __m128 r1 = _load4(this->data[1]);
+    __m128 r2 = _load4(this->data[2]);
+    __m128 r3 = _load4(this->data[3]);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _store4(dst, _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(r0, _mm_set1_ps(v[0])), _mm_mul_ps(r1, _mm_set1_ps(v[1]))),
+        _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(v[2])), _mm_mul_ps(r3, _mm_set1_ps(v[3])))
+    ));
+    return dst;
+}
+#endif
+
+template<>
+template<>
+inline Matrix<f32, 4, 4> Matrix<f32, 4, 4>::operator * <4>(const Matrix<f32, 4, 4> &mat) const {
+    Matrix<f32, 4, 4> dst;
+    __m128 b0 = _load4(mat[0]);
+    __m128 b1 = _load4(mat[1]);
+    __m128 b2 = _load4(mat[2]);
+    __m128 b3 = _load4(mat[3]);
+
+    for (int i = 3; i >= 0; i--) {
+        const Vector<f32, 4> &a(this->data[i]);
+
+        _store4(dst[i], _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), b0), _mm_mul_ps(_mm_set1_ps(a[1]), b1)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), b2), _mm_mul_ps(_mm_set1_ps(a[3]), b3))
+        ));
+    }
+    return dst;
+}
+
+template<>
+inline Matrix<f32, 4, 4> Matrix<f32, 4, 4>::transpose() const {
+    Matrix<f32, 4, 4> dst;
+    __m128 r0 = _load4(this->data[0]);
+    __m128 r1 = _load4(this->data[1]);
+    __m128 r2 = _load4(this->data[2]);
+    __m128 r3 = _load4(this->data[3]);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _store4(dst[0], r0);
+    _store4(dst[1], r1);
+    _store4(dst[2], r2);
+    _store4(dst[3], r3);
+    return dst;
+}
+
+template<>
+inline void Matrix<f32, 4, 4>::copyTransposed(f32 *data) const {
+    __m128 r0 = _load4(this->data[0]);
+    __m128 r1 = _load4(this->data[1]);
+    __m128 r2 = _load4(this->data[2]);
+    __m128 r3 = _load4(this->data[3]);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(data +  0, r0);
+    _mm_storeu_ps(data +  4, r1);
+    _mm_storeu_ps(data +  8, r2);
+    _mm_storeu_ps(data + 12, r3);
+}
+
+
+inline void transpose(Matrix<f32, 4, 4> &mat) {
+    __m128 r0 = _load4(mat[0]);
+    __m128 r1 = _load4(mat[1]);
+    __m128 r2 = _load4(mat[2]);
+    __m128 r3 = _load4(mat[3]);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _store4(mat[0], r0);
+    _store4(mat[1], r1);
+    _store4(mat[2], r2);
+    _store4(mat[3], r3);
+}
+
+
+
+// 2x2 blocks are stored row-major in a single register: [ a b c d ]
+#define _swizzle(vec, x, y, z, w)  _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(w, z, y, x))
+
+inline __m128 _mat2mul(__m128 a, __m128 b) {
+    return _mm_add_ps(
+        _mm_mul_ps(a, _swizzle(b, 0, 3, 0, 3)),
+        _mm_mul_ps(_swizzle(a, 1, 0, 3, 2), _swizzle(b, 2, 1, 2, 1))
+    );
+}
+
+inline __m128 _mat2adjmul(__m128 a, __m128 b) {
+    return _mm_sub_ps(
+        _mm_mul_ps(_swizzle(a, 3, 3, 0, 0), b),
+        _mm_mul_ps(_swizzle(a, 1, 1, 2, 2), _swizzle(b, 2, 3, 0, 1))
+    );
+}
+
+inline __m128 _mat2muladj(__m128 a, __m128 b) {
+    return _mm_sub_ps(
+        _mm_mul_ps(a, _swizzle(b, 3, 0, 3, 0)),
+        _mm_mul_ps(_swizzle(a, 1, 0, 3, 2), _swizzle(b, 2, 1, 2, 1))
+    );
+}
+
+template<>
+inline Matrix<f32, 4, 4> inverse<f32, 4>(const Matrix<f32, 4, 4> &mat) {
+    const __m128 r0 = _load4(mat[0]);
+    const __m128 r1 = _load4(mat[1]);
+    const __m128 r2 = _load4(mat[2]);
+    const __m128 r3 = _load4(mat[3]);
+
+    // block decomposition M = [ A B ; C D ]
+    const __m128 a = _mm_movelh_ps(r0, r1);
+    const __m128 b = _mm_movehl_ps(r1, r0);
+    const __m128 c = _mm_movelh_ps(r2, r3);
+    const __m128 d = _mm_movehl_ps(r3, r2);
+
+    const __m128 determinants = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0)))
+    );
+    const __m128 detA = _swizzle(determinants, 0, 0, 0, 0);
+    const __m128 detB = _swizzle(determinants, 1, 1, 1, 1);
+    const __m128 detC = _swizzle(determinants, 2, 2, 2, 2);
+    const __m128 detD = _swizzle(determinants, 3, 3, 3, 3);
+
+    const __m128 dc = _mat2adjmul(d, c);
+    const __m128 ab = _mat2adjmul(a, b);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), _mat2mul(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), _mat2mul(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), _mat2muladj(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), _mat2muladj(a, dc));
+
+    __m128 trace = _mm_mul_ps(ab, _swizzle(dc, 0, 2, 1, 3));
+
+    trace = _mm_add_ps(trace, _mm_movehl_ps(trace, trace));
+    trace = _mm_add_ss(trace, _swizzle(trace, 1, 1, 1, 1));
+
+    const f32 det = _mm_cvtss_f32(_mm_sub_ss(
+        _mm_add_ss(_mm_mul_ss(detA, detD), _mm_mul_ss(detB, detC)),
+        trace
+    ));
+
+    // |det| is bounded by the product of the row norms whatever the scale of
+    // each row, close to zero relative to it lu() decides on singularity
+    __m128 s0 = _mm_mul_ps(r0, r0);
+    __m128 s1 = _mm_mul_ps(r1, r1);
+    __m128 s2 = _mm_mul_ps(r2, r2);
+    __m128 s3 = _mm_mul_ps(r3, r3);
+
+    _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+
+    __m128 norms = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+
+    norms = _mm_mul_ps(norms, _mm_movehl_ps(norms, norms));
+    norms = _mm_mul_ss(norms, _swizzle(norms, 1, 1, 1, 1));
+
+    if (!(_abs(det) > _eps<f32>(40.0f) * _mm_cvtss_f32(norms))) {
+        Matrix<f32, 4, 4> decomposition;
+        int pivots[4];
+
+        if (!lu(mat, decomposition, pivots)) {
+            return pseudoInverse(mat);
+        }
+    }
+
+    const __m128 detInverse = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), _mm_set1_ps(det));
+    Matrix<f32, 4, 4> dst;
+
+    x = _mm_mul_ps(x, detInverse);
+    y = _mm_mul_ps(y, detInverse);
+    z = _mm_mul_ps(z, detInverse);
+    w = _mm_mul_ps(w, detInverse);
+    _store4(dst[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _store4(dst[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _store4(dst[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+    _store4(dst[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+    return dst;
+}
+
+#undef _swizzle
+
+#endif //__SSE__
+
+
+#endif //__MATH_SIMD_H_INCLUDE__
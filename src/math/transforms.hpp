@@ -24,6 +24,289 @@
 #define __MATH_TRANSFORMS_H_INCLUDE__
 
 
+// 3x4 affine transform [ L | t ], the implicit last row is [ 0 0 0 1 ]
+template<typename T>
+class Affine3 {
+public:
+    typedef Vector<T, 3> V;
+    typedef Matrix<T, 3, 3> L;
+    typedef Matrix<T, 4, 4> M;
+
+
+protected:
+    Matrix<T, 3, 4> data;
+
+
+public:
+    inline Affine3() {
+        this->data.identity();
+    }
+
+    inline Affine3(const Matrix<T, 3, 4> &mat) : data(mat) {
+    }
+
+    inline Affine3(const L &linear, const V &translation) {
+        for (int i = 2; i >= 0; i--) {
+            this->data[i] = linear[i];
+            this->data[i][3] = translation[i];
+        }
+    }
+
+    explicit inline Affine3(const M &mat) : data(mat) {
+    }
+
+    Affine3(const Affine3<T> &affine) = default;
+
+
+    Affine3<T> & operator =(const Affine3<T> &affine) = default;
+
+
+    inline Vector<T, 4> & operator [] (int i) {
+        return this->data[i];
+    }
+
+    inline const Vector<T, 4> & operator [] (int i) const {
+        return this->data[i];
+    }
+
+
+    inline L linear() const {
+        return L(this->data);
+    }
+
+    inline V translation() const {
+        return Vector3<T>(this->data[0][3], this->data[1][3], this->data[2][3]);
+    }
+
+
+    Affine3<T> operator * (const Affine3<T> &affine) const {
+        Affine3<T> dst;
+
+        for (int i = 2; i >= 0; i--) {
+            const Vector<T, 4> &a(this->data[i]);
+
+            for (int j = 3; j >= 0; j--) {
+                dst[i][j] = a[0] * affine[0][j] + a[1] * affine[1][j] + a[2] * affine[2][j];
+            }
+            dst[i][3] += a[3];
+        }
+        return dst;
+    }
+
+    inline Affine3<T> & operator *= (const Affine3<T> &affine) {
+        *this = *this * affine;
+        return *this;
+    }
+
+
+    inline V transformPoint(const V &p) const {
+        return Vector3<T>(
+            this->data[0][0] * p[0] + this->data[0][1] * p[1] + this->data[0][2] * p[2] + this->data[0][3],
+            this->data[1][0] * p[0] + this->data[1][1] * p[1] + this->data[1][2] * p[2] + this->data[1][3],
+            this->data[2][0] * p[0] + this->data[2][1] * p[1] + this->data[2][2] * p[2] + this->data[2][3]
+        );
+    }
+
+    inline V transformDirection(const V &d) const {
+        return Vector3<T>(
+            this->data[0][0] * d[0] + this->data[0][1] * d[1] + this->data[0][2] * d[2],
+            this->data[1][0] * d[0] + this->data[1][1] * d[1] + this->data[1][2] * d[2],
+            this->data[2][0] * d[0] + this->data[2][1] * d[1] + this->data[2][2] * d[2]
+        );
+    }
+
+    void transformPoints(const V *src, V *dst, i32u count) const {
+        for (i32u i = 0; i < count; i++) {
+            dst[i] = this->transformPoint(src[i]);
+        }
+    }
+
+    void transformDirections(const V *src, V *dst, i32u count) const {
+        for (i32u i = 0; i < count; i++) {
+            dst[i] = this->transformDirection(src[i]);
+        }
+    }
+
+    inline void transformPoints(const vector<V> &src, vector<V> &dst) const {
+        dst.resize(src.size());
+        this->transformPoints(src.data(), dst.data(), src.size());
+    }
+
+    inline void transformDirections(const vector<V> &src, vector<V> &dst) const {
+        dst.resize(src.size());
+        this->transformDirections(src.data(), dst.data(), src.size());
+    }
+
+
+    M matrix() const {
+        M dst(this->data);
+
+        dst[3][3] = T(1);
+        return dst;
+    }
+
+    inline void copy(T *data) const {
+        this->matrix().copy(data);
+    }
+
+    inline void copyTransposed(T *data) const {
+        this->matrix().copyTransposed(data);
+    }
+
+
+    void print(const char *name) const {
+        printf("%s\n", name);
+        this->print();
+        printf("\n");
+    }
+
+    void print() const {
+        printf("Affine3\n");
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 4; j++) {
+                if (j > 0) {
+                    printf(" ");
+                }
+                printf("%.05f", (double)this->data[i][j]);
+            }
+            printf("\n");
+        }
+    }
+};
+
+
+template<typename T>
+Affine3<T> inverse(const Affine3<T> &affine) {
+    const Vector<T, 3> r0(affine[0]);
+    const Vector<T, 3> r1(affine[1]);
+    const Vector<T, 3> r2(affine[2]);
+    const Vector<T, 3> c0(cross(r1, r2));
+    const Vector<T, 3> c1(cross(r2, r0));
+    const Vector<T, 3> c2(cross(r0, r1));
+    const T det(r0.dot(c0));
+    Matrix<T, 3, 3> linear;
+
+    if (_ne0(det)) {
+        const T detInverse(T(1) / det);
+
+        for (int i = 2; i >= 0; i--) {
+            linear[i][0] = c0[i] * detInverse;
+            linear[i][1] = c1[i] * detInverse;
+            linear[i][2] = c2[i] * detInverse;
+        }
+    } else {
+        linear = inverse(affine.linear());
+    }
+    return Affine3<T>(linear, -(linear * affine.translation()));
+}
+
+// inverse of a rotation + translation, the linear part must be orthonormal
+template<typename T>
+Affine3<T> rigidInverse(const Affine3<T> &affine) {
+    const Matrix<T, 3, 3> linear(affine.linear().transpose());
+
+    return Affine3<T>(linear, -(linear * affine.translation()));
+}
+
+
+template<typename T>
+inline Affine3<T> IdentityAffine() {
+    return Affine3<T>();
+}
+
+template<typename T>
+inline Affine3<T> TranslateAffine(const T &x, const T &y, const T &z) {
+    Affine3<T> dst;
+
+    dst[0][3] = x;
+    dst[1][3] = y;
+    dst[2][3] = z;
+    return dst;
+}
+
+template<typename T>
+inline Affine3<T> TranslateAffine(const Vector<T, 3> &vec) {
+    return TranslateAffine(vec[0], vec[1], vec[2]);
+}
+
+template<typename T>
+inline Affine3<T> ScaleAffine(const T &x, const T &y, const T &z) {
+    Affine3<T> dst;
+
+    dst[0][0] = x;
+    dst[1][1] = y;
+    dst[2][2] = z;
+    return dst;
+}
+
+template<typename T>
+inline Affine3<T> ScaleAffine(const Vector<T, 3> &vec) {
+    return ScaleAffine(vec[0], vec[1], vec[2]);
+}
+
+template<typename T>
+inline Affine3<T> RotateAffine(const T &angle, const T &x, const T &y, const T &z) {
+    const Vector<T, 3> axis(normalize(Vector3<T>(x, y, z)));
+    const T &nx(axis[0]);
+    const T &ny(axis[1]);
+    const T &nz(axis[2]);
+    const T s(_sin(angle));
+    const T c(_cos(angle));
+
+    return Affine3<T>(
+        Matrix3x3<T>(
+            nx * nx * (T(1) - c) +      c,  nx * ny * (T(1) - c) - nz * s,  nx * nz * (T(1) - c) + ny * s,
+            nx * ny * (T(1) - c) + nz * s,  ny * ny * (T(1) - c) +      c,  ny * nz * (T(1) - c) - nx * s,
+            nx * nz * (T(1) - c) - ny * s,  ny * nz * (T(1) - c) + nx * s,  nz * nz * (T(1) - c) +      c
+        ),
+        Vector<T, 3>()
+    );
+}
+
+template<typename T>
+inline Affine3<T> RotateAffine(const T &angle, const Vector<T, 3> &axis) {
+    return RotateAffine(angle, axis[0], axis[1], axis[2]);
+}
+
+template<typename T>
+inline Affine3<T> RotateXAffine(const T &angle) {
+    return RotateAffine(angle, T(1), T(0), T(0));
+}
+
+template<typename T>
+inline Affine3<T> RotateYAffine(const T &angle) {
+    return RotateAffine(angle, T(0), T(1), T(0));
+}
+
+template<typename T>
+inline Affine3<T> RotateZAffine(const T &angle) {
+    return RotateAffine(angle, T(0), T(0), T(1));
+}
+
+template<typename T>
+inline Affine3<T> LookAtAffine(const Vector<T, 3> &direction, const Vector<T, 3> &up) {
+    const Vector<T, 3> f(normalize(direction));
+    const Vector<T, 3> s(normalize(cross(f, normalize(up))));
+    const Vector<T, 3> u(normalize(cross(s, f)));
+
+    return Affine3<T>(
+        Matrix3x3<T>(
+            s[0],  u[0], -f[0],
+            s[1],  u[1], -f[1],
+            s[2],  u[2], -f[2]
+        ),
+        Vector<T, 3>()
+    );
+}
+
+template<typename T>
+inline Affine3<T> LookAtAffine(const Vector<T, 3> &eye, const Vector<T, 3> &center, const Vector<T, 3> &up) {
+    const Affine3<T> rotation(LookAtAffine(center - eye, up));
+
+    return Affine3<T>(rotation.linear(), -rotation.transformDirection(eye));
+}
+
+
 template<typename T>
 inline Matrix<T, 4, 4> IdentityTransform() {
     return Matrix4x4<T>(
@@ -66,19 +349,7 @@ inline Matrix<T, 4, 4> ScaleTransform(const Vector<T, 3> &vec) {
 
 template<typename T>
 inline Matrix<T, 4, 4> RotateTransform(const T &angle, const T &x, const T &y, const T &z) {
-    const Vector<T, 3> axis(normalize(Vector3<T>(x, y, z)));
-    const T &nx(axis[0]);
-    const T &ny(axis[1]);
-    const T &nz(axis[2]);
-    const T s(_sin(angle));
-    const T c(_cos(angle));
-
-    return Matrix4x4<T>(
-        nx * nx * (T(1) - c) +      c,  nx * ny * (T(1) - c) - nz * s,  nx * nz * (T(1) - c) + ny * s,  T(0),
-        nx * ny * (T(1) - c) + nz * s,  ny * ny * (T(1) - c) +      c,  ny * nz * (T(1) - c) - nx * s,  T(0),
-        nx * nz * (T(1) - c) - ny * s,  ny * nz * (T(1) - c) + nx * s,  nz * nz * (T(1) - c) +      c,  T(0),
-                                 T(0),                           T(0),                           T(0),  T(1)
-    );
+    return RotateAffine(angle, x, y, z).matrix();
 }
 
 template<typename T>
@@ -103,21 +374,12 @@ inline Matrix<T, 4, 4> RotateZTransform(const T &angle) {
 
 template<typename T>
 inline Matrix<T, 4, 4> LookAtTransform(const Vector<T, 3> &direction, const Vector<T, 3> &up) {
-    const Vector<T, 3> f(normalize(direction));
-    const Vector<T, 3> s(normalize(cross(f, normalize(up))));
-    const Vector<T, 3> u(normalize(cross(s, f)));
-
-    return Matrix4x4<T>(
-        s[0],  u[0], -f[0],  T(0),
-        s[1],  u[1], -f[1],  T(0),
-        s[2],  u[2], -f[2],  T(0),
-        T(0),  T(0),  T(0),  T(1)
-    );
+    return LookAtAffine(direction, up).matrix();
 }
 
 template<typename T>
 inline Matrix<T, 4, 4> LookAtTransform(const Vector<T, 3> &eye, const Vector<T, 3> &center, const Vector<T, 3> &up) {
-    return LookAtTransform(center - eye, up) * TranslateTransform(-eye);
+    return LookAtAffine(eye, center, up).matrix();
 }
 
 template<typename T>
@@ -0,0 +1,235 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+const i32u DrawBatcher::maxDraws;
+
+
+DrawBatcher::DrawBatcher() : drawCount(0), drawCalls(0), alignment(0) {
+}
+
+DrawBatcher::~DrawBatcher() {
+}
+
+
+// programs lacking the DrawTransforms block refuse their meshes, their
+// surfaces are then drawn on their own, without gl_DrawIDARB the draw index
+// is fed to the arena once when its group is created
+bool DrawBatcher::add(const shared_ptr<ShaderProgram> &program, const shared_ptr<MeshArena> &arena, const MeshArena::Mesh &mesh, const Matrix<f32, 4, 4> &transform) {
+    if (!DrawBatcher::supported() || !program || !arena || mesh.indexCount == 0) {
+        return false;
+    }
+
+    auto known = this->programs.find(program.get());
+
+    if (known == this->programs.end() || (*known).second.first.expired()) {
+        known = this->programs.insert(make_pair(program.get(), make_pair(weak_ptr<ShaderProgram>(), false))).first;
+        (*known).second.first = program;
+        (*known).second.second = program->hasStorageBlock("DrawTransforms");
+    }
+    if (!(*known).second.second) {
+        return false;
+    }
+
+    pair<const ShaderProgram *, const MeshArena *> key(program.get(), arena.get());
+    auto it = this->groups.find(key);
+
+    if (it == this->groups.end()) {
+        Group group;
+
+        group.program = program;
+        group.arena = arena;
+        if (!DrawBatcher::drawParameters()) {
+            if (!this->drawIDs) {
+                this->drawIDs.reset(new VertexBuffer<DrawIDFormat>(DrawBatcher::maxDraws));
+                for (i32u i = 0; i < DrawBatcher::maxDraws; i++) {
+                    this->drawIDs->set<0>(i, Vector<i32u, 1>(&i));
+                }
+                this->drawIDs->flush();
+            }
+            arena->attach(*this->drawIDs, *program, 1, 1);
+        }
+        it = this->groups.insert(make_pair(key, group)).first;
+    }
+
+    Group &group((*it).second);
+    DrawCommand command = {
+        mesh.indexCount,
+        1,
+        mesh.firstIndex,
+        (GLint)mesh.baseVertex,
+        (GLuint)(group.commands.size() % DrawBatcher::maxDraws)
+    };
+
+    group.commands.push_back(command);
+    group.transforms.push_back(transform);
+    this->drawCount++;
+    return true;
+}
+
+// commands and transforms of every group go through one streaming region
+// each, the transform slices are aligned for glBindBufferRange
+bool DrawBatcher::upload() {
+    i32u chunks = 0;
+
+    for (auto it = this->groups.begin(); it != this->groups.end(); it++) {
+        chunks += ((*it).second.commands.size() + DrawBatcher::maxDraws - 1) / DrawBatcher::maxDraws;
+    }
+
+    i32u commandSize = this->drawCount * sizeof(DrawCommand);
+    i32u transformSize = this->drawCount * sizeof(Matrix<f32, 4, 4>) + chunks * this->alignment;
+
+    if (!this->commands || this->commands->getRegionSize() < commandSize) {
+        this->commands.reset(new StreamingBuffer(GL_DRAW_INDIRECT_BUFFER, commandSize));
+    }
+    if (!this->transforms || this->transforms->getRegionSize() < transformSize) {
+        this->transforms.reset(new StreamingBuffer(GL_SHADER_STORAGE_BUFFER, transformSize));
+    }
+
+    bool complete = true;
+
+    this->commands->beginFrame();
+    this->transforms->beginFrame();
+    for (auto it = this->groups.begin(); it != this->groups.end(); it++) {
+        Group &group((*it).second);
+
+        group.commandOffsets.clear();
+        group.transformOffsets.clear();
+        for (i32u first = 0; first < group.commands.size(); first += DrawBatcher::maxDraws) {
+            i32u count = _min(DrawBatcher::maxDraws, (i32u)group.commands.size() - first);
+            i32u commandOffset = 0;
+            i32u transformOffset = 0;
+            GLvoid *commandData = this->commands->allocate(count * sizeof(DrawCommand), sizeof(GLuint), commandOffset);
+            GLvoid *transformData = this->transforms->allocate(count * sizeof(Matrix<f32, 4, 4>), this->alignment, transformOffset);
+
+            if (commandData == NULL || transformData == NULL) {
+                complete = false;
+                break;
+            }
+            memcpy(commandData, group.commands.data() + first, count * sizeof(DrawCommand));
+            memcpy(transformData, group.transforms.data() + first, count * sizeof(Matrix<f32, 4, 4>));
+            group.commandOffsets.push_back(commandOffset);
+            group.transformOffsets.push_back(transformOffset);
+        }
+    }
+    this->commands->endFrame();
+    this->transforms->endFrame();
+    return complete;
+}
+
+// batched meshes are drawn opaque, like flat surfaces; when they cannot be
+// streamed nothing is drawn and the caller draws their surfaces on their own
+bool DrawBatcher::draw(const shared_ptr<Renderer> &renderer) {
+    bool complete = true;
+
+    this->drawCalls = 0;
+    for (auto it = this->programs.begin(); it != this->programs.end(); ) {
+        if ((*it).second.first.expired()) {
+            it = this->programs.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (this->drawCount > 0) {
+        if (this->alignment == 0) {
+            GLint alignment = 0;
+
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            this->alignment = _max(alignment, 16);
+        }
+        if (!this->upload()) {
+            fprintf(stderr, "ERROR: Cannot stream the batched draws!\n");
+            complete = false;
+        } else {
+            GLState::applyRenderState(RenderState::opaque());
+        }
+    }
+
+    for (auto it = this->groups.begin(); it != this->groups.end(); ) {
+        Group &group((*it).second);
+
+        if (group.commands.empty()) {
+            it = this->groups.erase(it);
+            continue;
+        }
+
+        if (complete) {
+            group.program->enable();
+            group.arena->flush();
+            group.arena->bind();
+            GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commands->handle());
+            for (i32u i = 0; i < group.commandOffsets.size(); i++) {
+                i32u count = _min(DrawBatcher::maxDraws, (i32u)group.commands.size() - i * DrawBatcher::maxDraws);
+
+                this->transforms->bindRange(ShaderProgram::drawTransformsBinding, group.transformOffsets[i], count * sizeof(Matrix<f32, 4, 4>));
+                glMultiDrawElementsIndirect(
+                    GL_TRIANGLES,
+                    group.arena->indexType,
+                    reinterpret_cast<GLvoid*>((GLintptr)group.commandOffsets[i]),
+                    count,
+                    0
+                );
+                this->drawCalls++;
+            }
+            group.program->disable();
+        }
+
+        group.commands.clear();
+        group.transforms.clear();
+        it++;
+    }
+    this->drawCount = 0;
+    return complete;
+}
+
+
+// GL 4.3, or multi-draw indirect with storage blocks and base instances
+bool DrawBatcher::supported() {
+    static i32 supported = -1;
+
+    if (supported < 0) {
+        supported = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_base_instance) ? 1 : 0;
+    }
+    return supported > 0;
+}
+
+// GL 4.6 or ARB_shader_draw_parameters, gl_DrawIDARB indexes the transforms
+bool DrawBatcher::drawParameters() {
+    static i32 supported = -1;
+
+    if (supported < 0) {
+        supported = GLEW_VERSION_4_6 || GLEW_ARB_shader_draw_parameters ? 1 : 0;
+    }
+    return supported > 0;
+}
+
+// batched programs are built with these, they select how the draw is found
+ShaderPreprocessor::Defines DrawBatcher::defines() {
+    ShaderPreprocessor::Defines defines;
+
+    if (DrawBatcher::drawParameters()) {
+        defines["DRAW_PARAMETERS"] = "";
+    }
+    return defines;
+}
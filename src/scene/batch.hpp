@@ -0,0 +1,100 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __BATCH_H_INCLUDE__
+#define __BATCH_H_INCLUDE__
+
+
+struct DrawIDAttribute {
+    static inline const char * name() {
+        return "inDrawID";
+    }
+};
+
+
+// meshes added with the same program and arena are drawn by a single
+// glMultiDrawElementsIndirect, each draw reads its model matrix from the
+// DrawTransforms storage block at gl_DrawIDARB or, without shader draw
+// parameters, at the inDrawID instanced attribute its base instance selects
+class DrawBatcher {
+public:
+    typedef struct {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    } DrawCommand;
+
+    typedef VertexFormat<VertexAttribute<DrawIDAttribute, i32u, 1> > DrawIDFormat;
+
+
+    // draws per multi-draw, larger groups are split
+    static const i32u maxDraws = 4096;
+
+
+protected:
+    typedef struct {
+        shared_ptr<ShaderProgram> program;
+        shared_ptr<MeshArena> arena;
+        vector<DrawCommand> commands;
+        vector<Matrix<f32, 4, 4> > transforms;
+        vector<i32u> commandOffsets;
+        vector<i32u> transformOffsets;
+    } Group;
+
+
+    map<pair<const ShaderProgram *, const MeshArena *>, Group> groups;
+    // whether each program declares the DrawTransforms block, the weak
+    // pointer tells it apart from a later program at the same address
+    map<const ShaderProgram *, pair<weak_ptr<ShaderProgram>, bool> > programs;
+    i32u drawCount;
+    i32u drawCalls;
+    i32u alignment;
+    shared_ptr<StreamingBuffer> commands;
+    shared_ptr<StreamingBuffer> transforms;
+    shared_ptr<VertexBuffer<DrawIDFormat> > drawIDs;
+
+
+    bool upload();
+
+
+public:
+    DrawBatcher();
+    ~DrawBatcher();
+
+
+    bool add(const shared_ptr<ShaderProgram> &program, const shared_ptr<MeshArena> &arena, const MeshArena::Mesh &mesh, const Matrix<f32, 4, 4> &transform);
+    bool draw(const shared_ptr<Renderer> &renderer);
+
+    inline i32u getDrawCalls() const {
+        return this->drawCalls;
+    }
+
+
+    static bool supported();
+    static bool drawParameters();
+    static ShaderPreprocessor::Defines defines();
+};
+
+
+#endif //__BATCH_H_INCLUDE__
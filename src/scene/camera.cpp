@@ -23,7 +23,7 @@
 #include "archifake.hpp"
 
 
-Vector<f32, 3> Camera::unprojectPoint(const Vector<i32, 3> &window) {
+Vector<f32, 3> Camera::unprojectPoint(const Vector<i32, 3> &window) const {
     auto vec = this->projectionViewMatrixInverse() * Vector4<f32>(
         (f32)(2 * (window[0] - this->viewport.x())) / (f32)this->viewport.width() - 1,
         (f32)(2 * (window[1] - this->viewport.y())) / (f32)this->viewport.height() - 1,
@@ -34,7 +34,7 @@ Vector<f32, 3> Camera::unprojectPoint(const Vector<i32, 3> &window) {
     return Vector3<f32>(vec[0], vec[1], vec[2]);
 }
 
-Line<f32, 3> Camera::unprojectLine(const Vector<i32, 2> &window) {
+Line<f32, 3> Camera::unprojectLine(const Vector<i32, 2> &window) const {
     auto vec1 = this->projectionViewMatrixInverse() * Vector4<f32>(
         (f32)(2 * (window[0] - this->viewport.x())) / (f32)this->viewport.width() - 1,
         (f32)(2 * (window[1] - this->viewport.y())) / (f32)this->viewport.height() - 1,
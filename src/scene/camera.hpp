@@ -30,15 +30,25 @@ public:
 
 
 protected:
+    // derived matrix tagged with the input versions it was computed from
+    struct Derived {
+        M matrix;
+        i32u projectionVersion;
+        i32u viewVersion;
+    };
+
+
     M _projectionMatrix;
     M _viewMatrix;
+    i32u _projectionVersion;
+    i32u _viewVersion;
+    mutable Derived _projectionViewMatrix;
+    mutable Derived _projectionMatrixInverse;
+    mutable Derived _viewMatrixInverse;
+    mutable Derived _projectionViewMatrixInverse;
 
 
 public:
-    LazyInitialized<M> projectionViewMatrix;
-    LazyInitialized<M> projectionMatrixInverse;
-    LazyInitialized<M> viewMatrixInverse;
-    LazyInitialized<M> projectionViewMatrixInverse;
     Rectangle2<i32> viewport;
     Range<f64> depthRange;
     RGBA<f32> clearColor;
@@ -46,77 +56,24 @@ public:
     i32 clearStencil;
 
 
-    Camera() : _projectionMatrix(IdentityTransform<f32>()), _viewMatrix(IdentityTransform<f32>()),
-        projectionViewMatrix(
-            [] (M &mat) { mat = IdentityTransform<f32>(); }
-        ),
-        projectionMatrixInverse(
-            [] (M &mat) { mat = IdentityTransform<f32>(); }
-        ),
-        viewMatrixInverse(
-            [] (M &mat) { mat = IdentityTransform<f32>(); }
-        ),
-        projectionViewMatrixInverse(
-            [] (M &mat) { mat = IdentityTransform<f32>(); }
-        ),
+    Camera() : _projectionMatrix(IdentityTransform<f32>()), _viewMatrix(IdentityTransform<f32>()), _projectionVersion(1), _viewVersion(1),
+        _projectionViewMatrix(), _projectionMatrixInverse(), _viewMatrixInverse(), _projectionViewMatrixInverse(),
         depthRange(0.0, 1.0),
         clearDepth(1.0),
         clearStencil(0) {
     }
 
-    Camera(const M &projectionMatrix, const M &viewMatrix) : _projectionMatrix(projectionMatrix), _viewMatrix(viewMatrix),
-        projectionViewMatrix(
-            [this] (M &mat) { mat = this->_projectionMatrix * this->_viewMatrix; }
-        ),
-        projectionMatrixInverse(
-            [this] (M &mat) { mat = inverse(this->_projectionMatrix); }
-        ),
-        viewMatrixInverse(
-            [this] (M &mat) { mat = inverse(this->_viewMatrix); }
-        ),
-        projectionViewMatrixInverse(
-            [this] (M &mat) { mat = inverse(this->projectionViewMatrix()); }
-        ),
+    Camera(const M &projectionMatrix, const M &viewMatrix) : _projectionMatrix(projectionMatrix), _viewMatrix(viewMatrix), _projectionVersion(1), _viewVersion(1),
+        _projectionViewMatrix(), _projectionMatrixInverse(), _viewMatrixInverse(), _projectionViewMatrixInverse(),
         depthRange(0.0, 1.0),
         clearDepth(1.0),
         clearStencil(0) {
     }
 
-    Camera(const Camera &camera) : _projectionMatrix(camera._projectionMatrix), _viewMatrix(camera._viewMatrix),
-        projectionViewMatrix(
-            [this] (M &mat) { mat = this->_projectionMatrix * this->_viewMatrix; }
-        ),
-        projectionMatrixInverse(
-            [this] (M &mat) { mat = inverse(this->_projectionMatrix); }
-        ),
-        viewMatrixInverse(
-            [this] (M &mat) { mat = inverse(this->_viewMatrix); }
-        ),
-        projectionViewMatrixInverse(
-            [this] (M &mat) { mat = inverse(this->projectionViewMatrix()); }
-        ),
-        viewport(camera.viewport),
-        depthRange(camera.depthRange),
-        clearColor(camera.clearColor),
-        clearDepth(camera.clearDepth),
-        clearStencil(camera.clearStencil) {
-    }
+    Camera(const Camera &camera) = default;
 
 
-    Camera & operator =(const Camera &camera) {
-        this->_projectionMatrix = camera._projectionMatrix;
-        this->_viewMatrix = camera._viewMatrix;
-        this->projectionViewMatrix = camera.projectionViewMatrix;
-        this->projectionMatrixInverse = camera.projectionMatrixInverse;
-        this->viewMatrixInverse = camera.viewMatrixInverse;
-        this->projectionViewMatrixInverse = camera.projectionViewMatrixInverse;
-        this->viewport = camera.viewport;
-        this->depthRange = camera.depthRange;
-        this->clearColor = camera.clearColor;
-        this->clearDepth = camera.clearDepth;
-        this->clearStencil = camera.clearStencil;
-        return *this;
-    }
+    Camera & operator =(const Camera &camera) = default;
 
 
     inline const M &projectionMatrix() const {
@@ -127,26 +84,88 @@ public:
         return this->_viewMatrix;
     }
 
+    const M &projectionViewMatrix() const {
+        Derived &derived(this->_projectionViewMatrix);
+
+        if (derived.projectionVersion != this->_projectionVersion || derived.viewVersion != this->_viewVersion) {
+            derived.matrix = this->_projectionMatrix * this->_viewMatrix;
+            derived.projectionVersion = this->_projectionVersion;
+            derived.viewVersion = this->_viewVersion;
+        }
+        return derived.matrix;
+    }
+
+    const M &projectionMatrixInverse() const {
+        Derived &derived(this->_projectionMatrixInverse);
+
+        if (derived.projectionVersion != this->_projectionVersion) {
+            derived.matrix = inverse(this->_projectionMatrix);
+            derived.projectionVersion = this->_projectionVersion;
+        }
+        return derived.matrix;
+    }
+
+    const M &viewMatrixInverse() const {
+        Derived &derived(this->_viewMatrixInverse);
+
+        if (derived.viewVersion != this->_viewVersion) {
+            derived.matrix = inverse(this->_viewMatrix);
+            derived.viewVersion = this->_viewVersion;
+        }
+        return derived.matrix;
+    }
+
+    const M &projectionViewMatrixInverse() const {
+        Derived &derived(this->_projectionViewMatrixInverse);
+
+        if (derived.projectionVersion != this->_projectionVersion || derived.viewVersion != this->_viewVersion) {
+            derived.matrix = inverse(this->projectionViewMatrix());
+            derived.projectionVersion = this->_projectionVersion;
+            derived.viewVersion = this->_viewVersion;
+        }
+        return derived.matrix;
+    }
+
+
+    // the versions only move when the matrix actually changes, so derived
+    // matrices survive redundant per-frame updates
+    inline void setProjectionMatrix(const M &projectionMatrix) {
+        if (memcmp(&this->_projectionMatrix, &projectionMatrix, sizeof(M)) != 0) {
+            this->_projectionMatrix = projectionMatrix;
+            this->_projectionVersion++;
+        }
+    }
+
+    inline void setViewMatrix(const M &viewMatrix) {
+        if (memcmp(&this->_viewMatrix, &viewMatrix, sizeof(M)) != 0) {
+            this->_viewMatrix = viewMatrix;
+            this->_viewVersion++;
+        }
+    }
+
 
     inline Camera withProjectionMatrix(const M &projectionMatrix) const {
         Camera copy(*this);
 
-        copy._projectionMatrix = projectionMatrix;
+        copy.setProjectionMatrix(projectionMatrix);
         return copy;
     }
 
     inline Camera withViewMatrix(const M &viewMatrix) const {
         Camera copy(*this);
 
-        copy._viewMatrix = viewMatrix;
+        copy.setViewMatrix(viewMatrix);
         return copy;
     }
 
 
-    Vector<f32, 3> unprojectPoint(const Vector<i32, 3> &window);
+    Vector<f32, 3> unprojectPoint(const Vector<i32, 3> &window) const;
 
-    Line<f32, 3> unprojectLine(const Vector<i32, 2> &window);
+    Line<f32, 3> unprojectLine(const Vector<i32, 2> &window) const;
 };
 
 
+static_assert(is_trivially_copyable<Camera>::value, "Camera must stay trivially copyable");
+
+
 #endif //__CAMERA_H_INCLUDE__
\ No newline at end of file
@@ -0,0 +1,101 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+RenderQueue::RenderQueue() {
+}
+
+RenderQueue::~RenderQueue() {
+}
+
+
+// states are interned for the lifetime of the queue, a scene only uses a few
+i32u RenderQueue::renderStateIndex(const RenderState &state) {
+    for (i32u i = 0; i < this->renderStates.size(); i++) {
+        if (this->renderStates[i] == state) {
+            return i;
+        }
+    }
+    this->renderStates.push_back(state);
+    return this->renderStates.size() - 1;
+}
+
+void RenderQueue::submit(Surface *surface, const PipelineState &state) {
+    DrawItem item = {
+        0,
+        surface,
+        state
+    };
+
+    this->items.push_back(item);
+}
+
+// keys need the camera of the frame, they are computed once all draws are in
+void RenderQueue::execute(const shared_ptr<Renderer> &renderer) {
+    const Matrix<f32, 4, 4> &view(renderer->camera.viewMatrix());
+
+    for (auto it = this->items.begin(); it != this->items.end(); it++) {
+        DrawItem &item(*it);
+        Vector<f32, 3> position(item.surface->getModelTransform().translation());
+        f32 depth = -(view[2][0] * position[0] + view[2][1] * position[1] + view[2][2] * position[2] + view[2][3]);
+
+        item.key = RenderQueue::sortKey(
+            item.state.renderState.blend,
+            item.state.program,
+            this->renderStateIndex(item.state.renderState),
+            item.state.vertexArray,
+            depth
+        );
+    }
+    sort(this->items.begin(), this->items.end(), [] (const DrawItem &a, const DrawItem &b) {
+        return a.key < b.key;
+    });
+    for (auto it = this->items.begin(); it != this->items.end(); it++) {
+        (*it).surface->render(renderer);
+    }
+    this->items.clear();
+}
+
+
+// opaque:      0 | program:15 | render state:12 | vertex array:16 | depth:20
+// translucent: 1 | ~depth:20 | program:15 | render state:12 | vertex array:16
+// the depth bits are the top of the float bits, which order like the value
+// for positive floats; draws behind the eye all get depth 0
+i64u RenderQueue::sortKey(bool translucent, i32u program, i32u renderState, i32u vertexArray, f32 depth) {
+    i32u bits = 0;
+    i64u state;
+
+    depth = _max(depth, 0.0f);
+    memcpy(&bits, &depth, sizeof(bits));
+    bits >>= 12;
+
+    state =
+        ((i64u)(program & 0x7fff) << 28) |
+        ((i64u)(renderState & 0xfff) << 16) |
+        (i64u)(vertexArray & 0xffff);
+    if (translucent) {
+        return (1ULL << 63) | ((i64u)(~bits & 0xfffff) << 43) | state;
+    }
+    return (state << 20) | bits;
+}
@@ -0,0 +1,77 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __QUEUE_H_INCLUDE__
+#define __QUEUE_H_INCLUDE__
+
+
+class Surface;
+
+
+// everything a draw needs bound, draws with equal states are sorted next
+// to each other
+typedef struct {
+    RenderState renderState;
+    GLuint program;
+    GLuint vertexArray;
+} PipelineState;
+
+
+// draws of a frame sorted by pipeline state, then front to back; translucent
+// draws come last, back to front, so they blend over everything else.
+// Surfaces apply their state through GLState, only the differences between
+// consecutive draws reach GL
+class RenderQueue {
+public:
+    typedef struct {
+        i64u key;
+        Surface *surface;
+        PipelineState state;
+    } DrawItem;
+
+
+protected:
+    vector<DrawItem> items;
+    vector<RenderState> renderStates;
+
+
+    i32u renderStateIndex(const RenderState &state);
+
+
+public:
+    RenderQueue();
+    ~RenderQueue();
+
+
+    void submit(Surface *surface, const PipelineState &state);
+    void execute(const shared_ptr<Renderer> &renderer);
+
+    inline i32u size() const {
+        return this->items.size();
+    }
+
+
+    static i64u sortKey(bool translucent, i32u program, i32u renderState, i32u vertexArray, f32 depth);
+};
+
+
+#endif //__QUEUE_H_INCLUDE__
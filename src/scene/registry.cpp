@@ -0,0 +1,150 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+const SurfaceRegistry::Handle SurfaceRegistry::invalid;
+const i32u SurfaceRegistry::slotBits;
+const i32u SurfaceRegistry::slotMask;
+
+
+SurfaceRegistry::SurfaceRegistry() {
+}
+
+SurfaceRegistry::~SurfaceRegistry() {
+}
+
+
+// a name already in use keeps its handle, its surface is replaced and
+// starts over hidden and stopped
+SurfaceRegistry::Handle SurfaceRegistry::add(const string &name, const shared_ptr<Surface> &surface) {
+    Handle handle = this->find(name);
+    i32 i = this->index(handle);
+
+    if (i >= 0) {
+        this->surfaces[i] = surface;
+        this->started[i] = 0;
+        this->visible[i] = 0;
+        this->startTicks[i] = 0;
+        this->lastTicks[i] = 0;
+        this->renderCounts[i] = 0;
+        return handle;
+    }
+
+    i32u slot;
+
+    if (!this->freeSlots.empty()) {
+        slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    } else {
+        slot = this->slots.size();
+        if (slot > SurfaceRegistry::slotMask) {
+            fprintf(stderr, "ERROR: Too many surfaces!\n");
+            return SurfaceRegistry::invalid;
+        }
+        this->slots.push_back(0);
+        this->generations.push_back(1);
+    }
+
+    this->slots[slot] = this->surfaces.size();
+    this->surfaces.push_back(surface);
+    this->started.push_back(0);
+    this->visible.push_back(0);
+    this->startTicks.push_back(0);
+    this->lastTicks.push_back(0);
+    this->renderCounts.push_back(0);
+    this->names.push_back(name);
+    this->owners.push_back(slot);
+
+    handle = (this->generations[slot] << SurfaceRegistry::slotBits) | slot;
+    this->handles[name] = handle;
+    return handle;
+}
+
+// the slot gets a new generation, so stale handles no longer resolve
+bool SurfaceRegistry::remove(Handle handle) {
+    i32 i = this->index(handle);
+
+    if (i < 0) {
+        return false;
+    }
+
+    i32u slot = handle & SurfaceRegistry::slotMask;
+    i32u last = this->surfaces.size() - 1;
+
+    this->handles.erase(this->names[i]);
+    if ((i32u)i != last) {
+        this->surfaces[i] = this->surfaces[last];
+        this->started[i] = this->started[last];
+        this->visible[i] = this->visible[last];
+        this->startTicks[i] = this->startTicks[last];
+        this->lastTicks[i] = this->lastTicks[last];
+        this->renderCounts[i] = this->renderCounts[last];
+        this->names[i] = this->names[last];
+        this->owners[i] = this->owners[last];
+        this->slots[this->owners[i]] = i;
+    }
+    this->surfaces.pop_back();
+    this->started.pop_back();
+    this->visible.pop_back();
+    this->startTicks.pop_back();
+    this->lastTicks.pop_back();
+    this->renderCounts.pop_back();
+    this->names.pop_back();
+    this->owners.pop_back();
+
+    // generation 0 is skipped so that no handle ever equals invalid
+    this->generations[slot] = (this->generations[slot] + 1) & (0xffffffff >> SurfaceRegistry::slotBits);
+    if (this->generations[slot] == 0) {
+        this->generations[slot] = 1;
+    }
+    this->freeSlots.push_back(slot);
+    return true;
+}
+
+void SurfaceRegistry::clear() {
+    while (!this->surfaces.empty()) {
+        this->remove((this->generations[this->owners.back()] << SurfaceRegistry::slotBits) | this->owners.back());
+    }
+}
+
+
+// dense index of the surface, -1 for stale or invalid handles
+i32 SurfaceRegistry::index(Handle handle) const {
+    i32u slot = handle & SurfaceRegistry::slotMask;
+
+    if (handle == SurfaceRegistry::invalid || slot >= this->slots.size() || this->generations[slot] != (handle >> SurfaceRegistry::slotBits)) {
+        return -1;
+    }
+    return this->slots[slot];
+}
+
+// unknown names give the invalid handle, nothing is inserted
+SurfaceRegistry::Handle SurfaceRegistry::find(const string &name) const {
+    auto it = this->handles.find(name);
+
+    if (it == this->handles.end()) {
+        return SurfaceRegistry::invalid;
+    }
+    return (*it).second;
+}
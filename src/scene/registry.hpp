@@ -0,0 +1,79 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __REGISTRY_H_INCLUDE__
+#define __REGISTRY_H_INCLUDE__
+
+
+// slot map of the surfaces of a scene: handles stay valid until their
+// surface is removed, while the per-surface columns stay dense and are
+// walked linearly every frame; removal moves the last surface into the
+// hole, so the dense order is not stable
+class SurfaceRegistry {
+public:
+    typedef i32u Handle;
+
+    static const Handle invalid = 0;
+    // low bits of a handle select the slot, the high bits carry the
+    // generation of the slot when the handle was given out
+    static const i32u slotBits = 20;
+    static const i32u slotMask = (1 << SurfaceRegistry::slotBits) - 1;
+
+
+protected:
+    friend class Scene;
+
+
+    vector<shared_ptr<Surface> > surfaces;
+    vector<i8u> started;
+    vector<i8u> visible;
+    vector<i64u> startTicks;
+    vector<i64u> lastTicks;
+    vector<i64u> renderCounts;
+    vector<string> names;
+    vector<i32u> owners;
+
+    vector<i32u> slots;
+    vector<i32u> generations;
+    vector<i32u> freeSlots;
+    map<string, Handle> handles;
+
+
+public:
+    SurfaceRegistry();
+    ~SurfaceRegistry();
+
+
+    Handle add(const string &name, const shared_ptr<Surface> &surface);
+    bool remove(Handle handle);
+    void clear();
+
+    i32 index(Handle handle) const;
+    Handle find(const string &name) const;
+
+    inline i32u size() const {
+        return this->surfaces.size();
+    }
+};
+
+
+#endif //__REGISTRY_H_INCLUDE__
@@ -0,0 +1,49 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+static_assert(sizeof(Renderer::FrameConstants) == 3 * 16 * sizeof(f32), "FrameConstants must match the std140 block");
+
+
+void Renderer::updateFrameConstants() {
+    FrameConstants constants = {
+        this->camera.projectionMatrix(),
+        this->camera.viewMatrix(),
+        this->camera.projectionViewMatrix()
+    };
+
+    if (!this->frameConstants) {
+        this->frameConstants.reset(new UniformBuffer(sizeof(FrameConstants), NULL, GL_STREAM_DRAW));
+    }
+    this->frameConstants->setData(0, sizeof(FrameConstants), &constants);
+    this->frameConstants->bindBase(ShaderProgram::frameConstantsBinding);
+
+    if (!this->surfaceConstants) {
+        BlockLayout layout(BlockLayout::STD140);
+
+        layout.add("mMatrix", GL_FLOAT_MAT4, 1, true);
+        this->surfaceConstants.reset(new BlockWriter(layout));
+    }
+    this->surfaceConstants->clear();
+}
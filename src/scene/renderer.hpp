@@ -25,8 +25,30 @@
 
 
 class Renderer {
+public:
+    // std140 layout of the FrameConstants block, matrices are declared row_major
+    typedef struct {
+        Matrix<f32, 4, 4> pMatrix;
+        Matrix<f32, 4, 4> vMatrix;
+        Matrix<f32, 4, 4> pvMatrix;
+    } FrameConstants;
+
+    // member indices of the SurfaceConstants block layout
+    static const i32u surfaceModelMatrix = 0;
+
+
+protected:
+    shared_ptr<UniformBuffer> frameConstants;
+    shared_ptr<BlockWriter> surfaceConstants;
+
+
+    void updateFrameConstants();
+
+
 public:
     Camera camera;
+    // pending readbacks are delivered at the end of each frame
+    Readback readback;
 
 
     Renderer() {
@@ -40,6 +62,10 @@ public:
 
     virtual i32 height() const = 0;
 
+    inline const shared_ptr<BlockWriter> & getSurfaceConstants() const {
+        return this->surfaceConstants;
+    }
+
     f32 ratio() const {
         if (this->height() > 0) {
             return (f32)this->width() / (f32)this->height();
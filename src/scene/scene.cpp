@@ -23,110 +23,180 @@
 #include "archifake.hpp"
 
 
-void SurfaceTask::start() {
-    if (!this->started && this->surface) {
-        this->started = true;
-        this->startTick = this->lastTick = Clock::tick();
-    }
-}
+const i32u Scene::animateGrain;
 
-void SurfaceTask::animate() {
-    if (this->started) {
-        f64 t = Clock::elapsed(this->startTick);
-        f64 dt = Clock::elapsed(this->lastTick);
 
-        this->lastTick = Clock::tick();
-        this->surface->animate(t, dt);
+void Scene::startAt(i32u i) {
+    if (!this->registry.started[i] && this->registry.surfaces[i]) {
+        this->registry.started[i] = 1;
+        this->registry.startTicks[i] = this->registry.lastTicks[i] = Clock::tick();
     }
 }
 
-void SurfaceTask::stop() {
-    if (this->started) {
-        this->lastTick = Clock::tick();
-        this->started = false;
+void Scene::stopAt(i32u i) {
+    if (this->registry.started[i]) {
+        this->registry.lastTicks[i] = Clock::tick();
+        this->registry.started[i] = 0;
     }
 }
 
-void SurfaceTask::show() {
-    if (!this->visible && this->surface) {
-        this->visible = true;
-    }
+// surfaces whose program is still compiling are skipped
+bool Scene::drawableAt(i32u i) const {
+    return this->registry.visible[i] && this->registry.surfaces[i]->isReady();
 }
 
-void SurfaceTask::render(const shared_ptr<Renderer> &renderer) {
-    if (this->visible) {
-        this->surface->render(renderer);
-        this->renderCount++;
-    }
-}
 
-void SurfaceTask::hide() {
-    if (this->visible) {
-        this->visible = false;
+void Scene::startAll() {
+    for (i32u i = 0; i < this->registry.size(); i++) {
+        this->startAt(i);
     }
 }
 
+void Scene::start(Handle handle) {
+    i32 i = this->registry.index(handle);
 
-void Scene::startAll() {
-    for (auto it = this->surfaces.begin(); it != this->surfaces.end(); it++) {
-        (*it).second.start();
+    if (i >= 0) {
+        this->startAt(i);
     }
 }
 
 void Scene::start(const string &name) {
-    this->surfaces[name].start();
+    this->start(this->registry.find(name));
+}
+
+void Scene::animateAt(i32u i, i64u now) {
+    f64 t = Clock::elapsed(this->registry.startTicks[i], now);
+    f64 dt = Clock::elapsed(this->registry.lastTicks[i], now);
+
+    this->registry.lastTicks[i] = now;
+    this->registry.surfaces[i]->animate(t, dt);
 }
 
+// every surface sees the same frame time; the thread-safe ones are spread
+// over the job system, the others follow on the calling thread
 void Scene::animate() {
-    for (auto it = this->surfaces.begin(); it != this->surfaces.end(); it++) {
-        (*it).second.animate();
+    i64u now = Clock::tick();
+
+    JobSystem::shared().parallelFor(this->registry.size(), [this, now] (i32u begin, i32u end) {
+        for (i32u i = begin; i < end; i++) {
+            if (this->registry.started[i] && this->registry.surfaces[i]->parallelAnimate()) {
+                this->animateAt(i, now);
+            }
+        }
+    }, Scene::animateGrain);
+    for (i32u i = 0; i < this->registry.size(); i++) {
+        if (this->registry.started[i] && !this->registry.surfaces[i]->parallelAnimate()) {
+            this->animateAt(i, now);
+        }
+    }
+}
+
+void Scene::stop(Handle handle) {
+    i32 i = this->registry.index(handle);
+
+    if (i >= 0) {
+        this->stopAt(i);
     }
 }
 
 void Scene::stop(const string &name) {
-    this->surfaces[name].stop();
+    this->stop(this->registry.find(name));
 }
 
 void Scene::stopAll() {
-    for (auto it = this->surfaces.begin(); it != this->surfaces.end(); it++) {
-        (*it).second.stop();
+    for (i32u i = 0; i < this->registry.size(); i++) {
+        this->stopAt(i);
     }
 }
 
 void Scene::showAll() {
-    for (auto it = this->surfaces.begin(); it != this->surfaces.end(); it++) {
-        (*it).second.show();
+    for (i32u i = 0; i < this->registry.size(); i++) {
+        this->registry.visible[i] = this->registry.surfaces[i] ? 1 : 0;
+    }
+}
+
+void Scene::show(Handle handle) {
+    i32 i = this->registry.index(handle);
+
+    if (i >= 0 && this->registry.surfaces[i]) {
+        this->registry.visible[i] = 1;
     }
 }
 
 void Scene::show(const string &name) {
-    this->surfaces[name].show();
+    this->show(this->registry.find(name));
 }
 
+// every per-surface block slice is written first and uploaded in one go,
+// opaque batches are drawn first so translucent queued draws end up on top,
+// batched surfaces go through the queue when their batches cannot be drawn
 void Scene::render(const shared_ptr<Renderer> &renderer) {
-    for (auto it = this->surfaces.begin(); it != this->surfaces.end(); it++) {
-        (*it).second.render(renderer);
+    this->batched.clear();
+    for (i32u i = 0; i < this->registry.size(); i++) {
+        if (this->drawableAt(i)) {
+            this->registry.surfaces[i]->update(renderer);
+        }
+    }
+    if (renderer->getSurfaceConstants()) {
+        renderer->getSurfaceConstants()->upload();
+    }
+    for (i32u i = 0; i < this->registry.size(); i++) {
+        if (this->drawableAt(i)) {
+            if (this->registry.surfaces[i]->batch(this->batcher)) {
+                this->batched.push_back(i);
+            } else {
+                this->registry.surfaces[i]->submit(this->queue);
+            }
+            this->registry.renderCounts[i]++;
+        }
+    }
+    if (!this->batcher.draw(renderer)) {
+        for (auto it = this->batched.begin(); it != this->batched.end(); it++) {
+            this->registry.surfaces[*it]->submit(this->queue);
+        }
+    }
+    this->queue.execute(renderer);
+}
+
+void Scene::hide(Handle handle) {
+    i32 i = this->registry.index(handle);
+
+    if (i >= 0) {
+        this->registry.visible[i] = 0;
     }
 }
 
 void Scene::hide(const string &name) {
-    this->surfaces[name].hide();
+    this->hide(this->registry.find(name));
 }
 
 void Scene::hideAll() {
-    for (auto it = this->surfaces.begin(); it != this->surfaces.end(); it++) {
-        (*it).second.hide();
+    for (i32u i = 0; i < this->registry.size(); i++) {
+        this->registry.visible[i] = 0;
     }
 }
 
-void Scene::addSurface(const string &name, const shared_ptr<Surface> &surface) {
-    this->surfaces[name] = surface;
+Scene::Handle Scene::addSurface(const string &name, const shared_ptr<Surface> &surface) {
+    return this->registry.add(name, surface);
+}
+
+void Scene::removeSurface(Handle handle) {
+    this->registry.remove(handle);
 }
 
 void Scene::removeSurface(const string &name) {
-    this->surfaces.erase(name);
+    this->registry.remove(this->registry.find(name));
 }
 
 void Scene::clearSurfaces() {
-    this->surfaces.clear();
+    this->registry.clear();
+}
+
+shared_ptr<Surface> Scene::surface(Handle handle) const {
+    i32 i = this->registry.index(handle);
+
+    if (i < 0) {
+        return shared_ptr<Surface>();
+    }
+    return this->registry.surfaces[i];
 }
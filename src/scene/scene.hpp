@@ -24,46 +24,26 @@
 #define __SCENE_H_INCLUDE__
 
 
-class SurfaceTask {
-protected:
-    shared_ptr<Surface> surface;
-
-    bool started;
-
-    i64u startTick;
-
-    i64u lastTick;
-
-    bool visible;
-
-    i64u renderCount;
-
-
+class Scene {
 public:
-    SurfaceTask() : started(false), startTick(0), lastTick(0), visible(false), renderCount(0) {
-    }
-
-    SurfaceTask(const shared_ptr<Surface> &surface) : surface(surface), started(false), startTick(0), lastTick(0), visible(false), renderCount(0) {
-    }
+    typedef SurfaceRegistry::Handle Handle;
 
-    ~SurfaceTask() {
-    }
-
-
-    void start();
-    void animate();
-    void stop();
+    // surfaces animated per job
+    static const i32u animateGrain = 64;
 
 
-    void show();
-    void render(const shared_ptr<Renderer> &renderer);
-    void hide();
-};
+protected:
+    SurfaceRegistry registry;
+    DrawBatcher batcher;
+    RenderQueue queue;
+    // surfaces handed to the batcher this frame
+    vector<i32u> batched;
 
 
-class Scene {
-protected:
-    map<string, SurfaceTask> surfaces;
+    void startAt(i32u i);
+    void stopAt(i32u i);
+    void animateAt(i32u i, i64u now);
+    bool drawableAt(i32u i) const;
 
 
 public:
@@ -75,21 +55,32 @@ public:
 
 
     void startAll();
+    void start(Handle handle);
     void start(const string &name);
     void animate();
+    void stop(Handle handle);
     void stop(const string &name);
     void stopAll();
 
     void showAll();
+    void show(Handle handle);
     void show(const string &name);
     void render(const shared_ptr<Renderer> &renderer);
+    void hide(Handle handle);
     void hide(const string &name);
     void hideAll();
 
 
-    void addSurface(const string &name, const shared_ptr<Surface> &surface);
+    Handle addSurface(const string &name, const shared_ptr<Surface> &surface);
+    void removeSurface(Handle handle);
     void removeSurface(const string &name);
     void clearSurfaces();
+
+    inline Handle surfaceHandle(const string &name) const {
+        return this->registry.find(name);
+    }
+
+    shared_ptr<Surface> surface(Handle handle) const;
 };
 
 
@@ -23,30 +23,103 @@
 #include "archifake.hpp"
 
 
-Surface::Surface() : id(GL_ZERO), modelMatrix(IdentityTransform<f32>()) {
-    glGenVertexArrays(1, &this->id);
+Surface::Surface() : id(GL_ZERO), modelTransform(), renderState(), prepared(false), constantsSlice(-1) {
 }
 
-Surface::Surface(const shared_ptr<ShaderProgram> &program) : id(GL_ZERO), modelMatrix(IdentityTransform<f32>()), program(program) {
-    glGenVertexArrays(1, &this->id);
+Surface::Surface(const shared_ptr<ShaderProgram> &program) : id(GL_ZERO), modelTransform(), program(program), renderState(), prepared(false), constantsSlice(-1) {
+}
+
+// direct state access needs a created name, a generated one only becomes
+// a vertex array once bound
+void Surface::createVertexArray() {
+    if (GLState::directStateAccess()) {
+        glCreateVertexArrays(1, &this->id);
+    } else {
+        glGenVertexArrays(1, &this->id);
+    }
 }
 
 Surface::~Surface() {
     if (this->id != GL_ZERO) {
-        glDeleteVertexArrays(1, &this->id);
+        GLState::deleteVertexArray(this->id);
+    }
+}
+
+// called on the first render, once the program has finished linking
+void Surface::setup() {
+    this->mMatrix = this->program->uniformHandle<Matrix<f32, 4, 4> >("mMatrix");
+}
+
+bool Surface::prepare() {
+    if (!this->prepared) {
+        if (!this->isReady()) {
+            return false;
+        }
+        this->setup();
+        this->prepared = true;
     }
+    return true;
+}
+
+bool Surface::isReady() const {
+    return this->program && this->program->isReady();
+}
+
+// animate() runs on the job system unless this says otherwise, it must
+// then only touch the surface itself and never call GL
+bool Surface::parallelAnimate() const {
+    return true;
 }
 
 void Surface::animate(f64 t, f64 dt) {
 }
 
+// writes this frame's slice of the SurfaceConstants block, the renderer
+// uploads every slice at once before the draws
+void Surface::update(const shared_ptr<Renderer> &renderer) {
+    const shared_ptr<BlockWriter> &constants(renderer->getSurfaceConstants());
+
+    if (!constants) {
+        return;
+    }
+    this->constantsSlice = constants->append();
+    constants->set(this->constantsSlice, Renderer::surfaceModelMatrix, this->modelTransform.matrix());
+}
+
+PipelineState Surface::pipelineState() const {
+    PipelineState state = {
+        this->renderState,
+        this->program ? this->program->handle() : GL_ZERO,
+        this->id
+    };
+
+    return state;
+}
+
+// surfaces drawn by a batcher are left to it, the others render themselves
+bool Surface::batch(DrawBatcher &batcher) {
+    return false;
+}
+
+void Surface::submit(RenderQueue &queue) {
+    queue.submit(this, this->pipelineState());
+}
+
 void Surface::render(const shared_ptr<Renderer> &renderer) {
+    if (!this->prepare()) {
+        return;
+    }
+
     this->program->enable();
+    GLState::applyRenderState(this->renderState);
 
-    this->program->uniform("pMatrix", renderer->camera.projectionMatrix());
-    this->program->uniform("vMatrix", renderer->camera.viewMatrix());
-    this->program->uniform("pvMatrix", renderer->camera.projectionViewMatrix());
-    this->program->uniform("pvmMatrix", renderer->camera.projectionViewMatrix() * this->modelMatrix);
+    // camera matrices come from the FrameConstants block bound by the renderer,
+    // programs without the SurfaceConstants block still get a plain mMatrix
+    if (this->constantsSlice >= 0) {
+        renderer->getSurfaceConstants()->bind(this->constantsSlice, ShaderProgram::surfaceConstantsBinding);
+        this->constantsSlice = -1;
+    }
+    this->program->uniform(this->mMatrix, this->modelTransform.matrix());
 
     this->renderImpl(renderer);
 
@@ -54,85 +127,206 @@ void Surface::render(const shared_ptr<Renderer> &renderer) {
 }
 
 
-FlatSurface::FlatSurface() : Surface(), vertices(4), triangles(2) {
-    this->setup();
+FlatSurface::FlatSurface() : Surface(), arena(), mesh({0, 0, 0, 0}), allocated(false) {
+    this->renderState = RenderState::opaque();
 }
 
-FlatSurface::FlatSurface(const shared_ptr<ShaderProgram> &program) : Surface(program), vertices(4), triangles(2) {
-    this->setup();
+FlatSurface::FlatSurface(const shared_ptr<ShaderProgram> &program) : Surface(program), arena(), mesh({0, 0, 0, 0}), allocated(false) {
+    this->renderState = RenderState::opaque();
 }
 
 FlatSurface::~FlatSurface() {
+    if (this->allocated) {
+        this->arena->release(this->mesh);
+    }
+}
+
+// flat surfaces whose programs declare the format attributes at the same
+// locations and with the same types share one arena, it lives as long as one
+// of them does
+shared_ptr<MeshArena> FlatSurface::sharedArena(const ShaderProgram &program) {
+    static map<vector<pair<GLint, GLenum> >, weak_ptr<MeshArena> > shared;
+    const VertexAttributeInfo *attributes = Format::attributes();
+    vector<pair<GLint, GLenum> > layout(Format::count);
+
+    for (i32u i = 0; i < Format::count; i++) {
+        const ShaderProgram::Attribute &input(program.attribute(attributes[i].name));
+
+        layout[i] = make_pair(input.location, input.type);
+    }
+
+    weak_ptr<MeshArena> &entry(shared[layout]);
+    shared_ptr<MeshArena> arena(entry.lock());
+
+    if (!arena) {
+        arena.reset(new MeshArena(Format::stride(), GL_UNSIGNED_BYTE, 4 * FlatSurface::arenaCapacity, 6 * FlatSurface::arenaCapacity));
+        arena->setup<Format>(program);
+        entry = arena;
+    }
+    return arena;
 }
 
 void FlatSurface::setup() {
-    if (this->id == GL_ZERO) {
+    static const Vertex vertices[4] = {
+        Vector2<f32>( 0.5,  0.5),
+        Vector2<f32>(-0.5,  0.5),
+        Vector2<f32>(-0.5, -0.5),
+        Vector2<f32>( 0.5, -0.5)
+    };
+    static const i8u indices[6] = {
+        0, 1, 2,
+        2, 3, 0
+    };
+
+    Surface::setup();
+    if (!this->arena) {
+        this->arena = FlatSurface::sharedArena(*this->program);
+    }
+    if (!this->allocated) {
+        if (!this->arena->allocate(4, 6, this->mesh)) {
+            fprintf(stderr, "ERROR: Flat surface arena is full!\n");
+            return;
+        }
+        this->allocated = true;
+    }
+
+    this->arena->setVertices(this->mesh, 0, 4, vertices);
+    this->arena->setIndices(this->mesh, 0, 6, indices);
+}
+
+void FlatSurface::renderImpl(const shared_ptr<Renderer> &renderer) {
+    if (!this->allocated) {
         return;
     }
 
-    GLint inPosition = this->program->attributeLocation("inPosition");
+    // edits made since the last frame are uploaded before the draw
+    this->arena->flush();
 
-    glBindVertexArray(this->id);
+    this->arena->draw(this->mesh);
+}
 
-    if (inPosition >= 0) {
-        this->vertices.setVertex(0, Vector2<f32>( 0.5,  0.5));
-        this->vertices.setVertex(1, Vector2<f32>(-0.5,  0.5));
-        this->vertices.setVertex(2, Vector2<f32>(-0.5, -0.5));
-        this->vertices.setVertex(3, Vector2<f32>( 0.5, -0.5));
-        this->vertices.enable();
+// every flat surface draws from the vertex array of the shared arena
+PipelineState FlatSurface::pipelineState() const {
+    PipelineState state(Surface::pipelineState());
 
-        glEnableVertexAttribArray(inPosition);
-        glVertexAttribDivisor(inPosition, 0);
-        glVertexAttribPointer(
-            inPosition,
-            2,
-            GL_FLOAT,
-            GL_FALSE,
-            0,
-            reinterpret_cast<GLvoid*>(0)
-        );
+    state.vertexArray = this->arena ? this->arena->handle() : GL_ZERO;
+    return state;
+}
 
-        this->vertices.disable();
+bool FlatSurface::batch(DrawBatcher &batcher) {
+    if (!this->prepare() || !this->allocated) {
+        return false;
     }
+    return batcher.add(this->program, this->arena, this->mesh, this->modelTransform.matrix());
+}
+
+void FlatSurface::animate(f64 t, f64 dt) {
+    this->modelTransform = RotateYQuaternion<f32>(t * M_PI).affine(Vector3<f32>(0, 0, -t));
+}
 
-    this->triangles.setFace(0, {0, 1, 2});
-    this->triangles.setFace(1, {2, 3, 0});
-    this->triangles.enable();
 
-    glBindVertexArray(GL_ZERO);
+InstancedSurface::InstancedSurface(const shared_ptr<ShaderProgram> &program, i32u capacity) :
+    Surface(program),
+    capacity(capacity),
+    vertices(4),
+    indices(2),
+    instances(capacity, GL_DYNAMIC_DRAW),
+    instanceCount(0)
+{
+    static const ElementBuffer<i8u, 3>::F faces[2] = {
+        { { 0, 1, 2 } },
+        { { 2, 3, 0 } }
+    };
+
+    this->vertices.set<0>(0, {
+        Vector2<f32>( 0.5,  0.5),
+        Vector2<f32>(-0.5,  0.5),
+        Vector2<f32>(-0.5, -0.5),
+        Vector2<f32>( 0.5, -0.5)
+    });
+    this->indices.setFaces(0, vector<ElementBuffer<i8u, 3>::F>(faces, faces + 2));
+    this->renderState = RenderState::opaque();
+}
 
-    this->triangles.disable();
+InstancedSurface::~InstancedSurface() {
+}
 
-    if (inPosition >= 0) {
-        glDisableVertexAttribArray(inPosition);
+void InstancedSurface::setup() {
+    Surface::setup();
+    if (this->id != GL_ZERO) {
+        return;
     }
-}
 
-void FlatSurface::renderImpl(const shared_ptr<Renderer> &renderer) {
+    this->createVertexArray();
     if (this->id == GL_ZERO) {
         return;
     }
+    if (GLState::directStateAccess()) {
+        glVertexArrayElementBuffer(this->id, this->indices.handle());
+    } else {
+        GLState::bindVertexArray(this->id);
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indices.handle());
+        GLState::bindVertexArray(GL_ZERO);
+    }
+    this->vertices.setup(this->id, *this->program, 0);
+    this->instances.setup(this->id, *this->program, 1, 1);
+}
 
-    glDepthFunc(GL_LEQUAL);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+void InstancedSurface::renderImpl(const shared_ptr<Renderer> &renderer) {
+    if (this->id == GL_ZERO || this->instanceCount == 0) {
+        return;
+    }
 
-    glBindVertexArray(this->id);
+    this->vertices.flush();
+    this->indices.flush();
+    this->instances.flush();
 
-    glDrawElements(
-        GL_TRIANGLES,
-        2 * 3,
-        GL_UNSIGNED_BYTE,
-        reinterpret_cast<GLvoid*>(0)
-    );
+    GLState::bindVertexArray(this->id);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, reinterpret_cast<GLvoid*>(0), this->instanceCount);
+}
 
-    glBindVertexArray(GL_ZERO);
 
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
+i32 InstancedSurface::addInstance(const Affine3<f32> &transform, const Color &color) {
+    if (this->instanceCount >= this->capacity) {
+        fprintf(stderr, "ERROR: Instanced surface is full!\n");
+        return -1;
+    }
+    this->setInstanceTransform(this->instanceCount, transform);
+    this->setInstanceColor(this->instanceCount, color);
+    return this->instanceCount++;
 }
 
-void FlatSurface::animate(f64 t, f64 dt) {
-    this->modelMatrix = TranslateTransform<f32>(0, 0, -t) * RotateYTransform<f32>(t * M_PI);
+void InstancedSurface::setInstanceTransform(i32u instance, const Affine3<f32> &transform) {
+    if (instance >= this->capacity) {
+        return;
+    }
+    this->instances.set<0>(instance, transform[0]);
+    this->instances.set<1>(instance, transform[1]);
+    this->instances.set<2>(instance, transform[2]);
+}
+
+void InstancedSurface::setInstanceColor(i32u instance, const Color &color) {
+    if (instance >= this->capacity) {
+        return;
+    }
+    this->instances.set<3>(instance, color);
+}
+
+// the last instance takes the place of the removed one
+void InstancedSurface::removeInstance(i32u instance) {
+    if (instance >= this->instanceCount) {
+        return;
+    }
+
+    this->instanceCount--;
+    if (instance != this->instanceCount) {
+        vector<i8u> last(InstanceFormat::stride());
+
+        this->instances.getData(this->instanceCount * InstanceFormat::stride(), last.size(), last.data());
+        this->instances.write(instance * InstanceFormat::stride(), last.size(), last.data());
+    }
+}
+
+void InstancedSurface::clearInstances() {
+    this->instanceCount = 0;
 }
@@ -28,11 +28,21 @@ class Surface {
 protected:
     GLuint id;
 
-    Matrix<f32, 4, 4> modelMatrix;
+    Affine3<f32> modelTransform;
 
     shared_ptr<ShaderProgram> program;
+    UniformHandle<Matrix<f32, 4, 4> > mMatrix;
 
+    RenderState renderState;
 
+    bool prepared;
+    i32 constantsSlice;
+
+
+    void createVertexArray();
+    bool prepare();
+
+    virtual void setup();
     virtual void renderImpl(const shared_ptr<Renderer> &renderer) = 0;
 
 
@@ -42,20 +52,39 @@ public:
     virtual ~Surface();
 
 
+    virtual bool isReady() const;
+
+    inline const Affine3<f32> & getModelTransform() const {
+        return this->modelTransform;
+    }
+
+    virtual PipelineState pipelineState() const;
+
+    virtual bool parallelAnimate() const;
     virtual void animate(f64 t, f64 dt);
+    virtual void update(const shared_ptr<Renderer> &renderer);
+    virtual bool batch(DrawBatcher &batcher);
+    virtual void submit(RenderQueue &queue);
     virtual void render(const shared_ptr<Renderer> &renderer);
 };
 
 
 class FlatSurface : public Surface {
-protected:
-    VertexAttributeBufferV<f32, 2> vertices;
+public:
+    typedef VertexFormat<VertexAttribute<PositionAttribute, f32, 2> > Format;
+    typedef Format::At<0>::type::V Vertex;
+
+    // quads held by each shared arena
+    static const i32u arenaCapacity = 4096;
 
-    ElementBuffer<i8u, 3> triangles;
 
+protected:
+    shared_ptr<MeshArena> arena;
+    MeshArena::Mesh mesh;
+    bool allocated;
 
-    void setup();
 
+    virtual void setup();
     virtual void renderImpl(const shared_ptr<Renderer> &renderer);
 
 
@@ -65,7 +94,69 @@ public:
     virtual ~FlatSurface();
 
 
+    virtual PipelineState pipelineState() const;
+
     virtual void animate(f64 t, f64 dt);
+    virtual bool batch(DrawBatcher &batcher);
+
+
+    static shared_ptr<MeshArena> sharedArena(const ShaderProgram &program);
+};
+
+
+// rows of the per-instance affine transform
+template<int row>
+struct ModelRowAttribute {
+    static inline const char * name() {
+        static const char *names[3] = { "inModelRow0", "inModelRow1", "inModelRow2" };
+
+        return names[row];
+    }
+};
+
+
+// one quad drawn many times with a single instanced draw, each instance
+// places the quad with its own transform (applied before the surface one)
+// and tints it with its own color
+class InstancedSurface : public Surface {
+public:
+    typedef VertexFormat<
+        VertexAttribute<ModelRowAttribute<0>, f32, 4>,
+        VertexAttribute<ModelRowAttribute<1>, f32, 4>,
+        VertexAttribute<ModelRowAttribute<2>, f32, 4>,
+        VertexAttribute<ColorAttribute, i8u, 4, true>
+    > InstanceFormat;
+    typedef InstanceFormat::At<3>::type::V Color;
+
+
+    const i32u capacity;
+
+
+protected:
+    VertexBuffer<FlatSurface::Format> vertices;
+    ElementBuffer<i8u, 3> indices;
+    VertexBuffer<InstanceFormat> instances;
+    i32u instanceCount;
+
+
+    virtual void setup();
+    virtual void renderImpl(const shared_ptr<Renderer> &renderer);
+
+
+public:
+    InstancedSurface(const shared_ptr<ShaderProgram> &program, i32u capacity);
+    virtual ~InstancedSurface();
+
+
+    i32 addInstance(const Affine3<f32> &transform, const Color &color);
+    void setInstanceTransform(i32u instance, const Affine3<f32> &transform);
+    void setInstanceColor(i32u instance, const Color &color);
+    void removeInstance(i32u instance);
+    void clearInstances();
+
+    inline i32u getInstanceCount() const {
+        return this->instanceCount;
+    }
 };
 
 
@@ -331,6 +331,7 @@ bool GLWindow::activate() {
     if (this->glxContext == NULL || this->glxWindow == None || !glXMakeContextCurrent(this->display, this->glxWindow, this->glxWindow, this->glxContext)) {
         return false;
     }
+    GLState::invalidate();
     return true;
 }
 
@@ -359,7 +360,10 @@ void GLWindow::beginFrame() {
             this->camera.clearColor.a()
         );
         glClearDepth(this->camera.clearDepth);
+        // a translucent draw of the last frame may have left depth writes off
+        GLState::depthMask(true);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        this->updateFrameConstants();
     }
 }
 
@@ -367,5 +371,7 @@ void GLWindow::endFrame() {
     if (this->glxContext != NULL && glXGetCurrentContext() == this->glxContext) {
         glFlush();
         glXSwapBuffers(this->display, this->glxWindow);
+        this->readback.poll();
     }
+    GLState::endFrame();
 }
@@ -0,0 +1,187 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+RangeAllocator::RangeAllocator(i32u capacity) : capacity(capacity), available(capacity) {
+    if (capacity > 0) {
+        this->blocks[0] = capacity;
+    }
+}
+
+bool RangeAllocator::allocate(i32u size, i32u &offset) {
+    if (size == 0) {
+        offset = 0;
+        return true;
+    }
+
+    for (auto it = this->blocks.begin(); it != this->blocks.end(); it++) {
+        if ((*it).second < size) {
+            continue;
+        }
+
+        offset = (*it).first;
+        if ((*it).second > size) {
+            this->blocks[offset + size] = (*it).second - size;
+        }
+        this->blocks.erase(it);
+        this->available -= size;
+        return true;
+    }
+    return false;
+}
+
+void RangeAllocator::release(i32u offset, i32u size) {
+    if (size == 0) {
+        return;
+    }
+
+    auto next = this->blocks.lower_bound(offset);
+
+    this->available += size;
+    if (next != this->blocks.end() && offset + size == (*next).first) {
+        size += (*next).second;
+        next = this->blocks.erase(next);
+    }
+    if (next != this->blocks.begin()) {
+        auto previous = next;
+
+        previous--;
+        if ((*previous).first + (*previous).second == offset) {
+            (*previous).second += size;
+            return;
+        }
+    }
+    this->blocks[offset] = size;
+}
+
+
+MeshArena::MeshArena(i32u vertexStride, GLenum indexType, i32u vertexCapacity, i32u indexCapacity) :
+    vertexStride(vertexStride),
+    indexType(indexType),
+    indexSize(MeshArena::getGLIndexSize(indexType)),
+    id(GL_ZERO),
+    vertices(GL_ARRAY_BUFFER, vertexCapacity * vertexStride),
+    indices(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * MeshArena::getGLIndexSize(indexType)),
+    vertexRanges(vertexCapacity),
+    indexRanges(indexCapacity),
+    configured(false)
+{
+    if (GLState::directStateAccess()) {
+        glCreateVertexArrays(1, &this->id);
+        if (this->id != GL_ZERO) {
+            glVertexArrayVertexBuffer(this->id, 0, this->vertices.handle(), 0, this->vertexStride);
+            glVertexArrayElementBuffer(this->id, this->indices.handle());
+        }
+        return;
+    }
+
+    glGenVertexArrays(1, &this->id);
+    if (this->id != GL_ZERO) {
+        GLState::bindVertexArray(this->id);
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indices.handle());
+        GLState::bindVertexArray(GL_ZERO);
+    }
+}
+
+MeshArena::~MeshArena() {
+    if (this->id != GL_ZERO) {
+        GLState::deleteVertexArray(this->id);
+    }
+}
+
+
+bool MeshArena::allocate(i32u vertexCount, i32u indexCount, Mesh &mesh) {
+    mesh.vertexCount = vertexCount;
+    mesh.indexCount = indexCount;
+    if (!this->vertexRanges.allocate(vertexCount, mesh.baseVertex)) {
+        return false;
+    }
+    if (!this->indexRanges.allocate(indexCount, mesh.firstIndex)) {
+        this->vertexRanges.release(mesh.baseVertex, vertexCount);
+        return false;
+    }
+    return true;
+}
+
+void MeshArena::release(const Mesh &mesh) {
+    this->vertexRanges.release(mesh.baseVertex, mesh.vertexCount);
+    this->indexRanges.release(mesh.firstIndex, mesh.indexCount);
+}
+
+// indices stay relative to the mesh, the base vertex is added at draw time
+void MeshArena::setVertices(const Mesh &mesh, i32u first, i32u count, const GLvoid *data) {
+    if (first + count > mesh.vertexCount) {
+        return;
+    }
+    this->vertices.write((mesh.baseVertex + first) * this->vertexStride, count * this->vertexStride, data);
+}
+
+void MeshArena::setIndices(const Mesh &mesh, i32u first, i32u count, const GLvoid *data) {
+    if (first + count > mesh.indexCount) {
+        return;
+    }
+    this->indices.write((mesh.firstIndex + first) * this->indexSize, count * this->indexSize, data);
+}
+
+
+void MeshArena::flush() {
+    this->vertices.flush();
+    this->indices.flush();
+}
+
+// the vertex array is left bound, consecutive draws from the same arena
+// do not switch it
+void MeshArena::bind() {
+    GLState::bindVertexArray(this->id);
+}
+
+void MeshArena::draw(const Mesh &mesh, GLenum mode) {
+    if (this->id == GL_ZERO || mesh.indexCount == 0) {
+        return;
+    }
+
+    this->bind();
+    glDrawElementsBaseVertex(
+        mode,
+        mesh.indexCount,
+        this->indexType,
+        reinterpret_cast<GLvoid*>((GLintptr)(mesh.firstIndex * this->indexSize)),
+        mesh.baseVertex
+    );
+}
+
+
+i32u MeshArena::getGLIndexSize(GLenum type) {
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+            return sizeof(i8u);
+
+        case GL_UNSIGNED_SHORT:
+            return sizeof(i16u);
+
+        case GL_UNSIGNED_INT:
+            return sizeof(i32u);
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __ARENA_H_INCLUDE__
+#define __ARENA_H_INCLUDE__
+
+
+// first-fit free list over [0, capacity), released ranges are merged
+// with their free neighbours
+class RangeAllocator {
+protected:
+    i32u capacity;
+    i32u available;
+    map<i32u, i32u> blocks;
+
+
+public:
+    RangeAllocator(i32u capacity);
+
+
+    bool allocate(i32u size, i32u &offset);
+    void release(i32u offset, i32u size);
+
+    inline i32u getCapacity() const {
+        return this->capacity;
+    }
+
+    inline i32u getAvailable() const {
+        return this->available;
+    }
+};
+
+
+// vertex and index ranges of many meshes sharing one vertex format, carved
+// out of a single vertex buffer and a single element buffer behind one
+// vertex array; meshes are drawn with their base vertex and first index
+class MeshArena {
+public:
+    typedef struct {
+        i32u baseVertex;
+        i32u vertexCount;
+        i32u firstIndex;
+        i32u indexCount;
+    } Mesh;
+
+
+    const i32u vertexStride;
+    const GLenum indexType;
+    const i32u indexSize;
+
+
+protected:
+    GLuint id;
+    ShadowedBuffer vertices;
+    ShadowedBuffer indices;
+    RangeAllocator vertexRanges;
+    RangeAllocator indexRanges;
+    bool configured;
+
+
+public:
+    MeshArena(i32u vertexStride, GLenum indexType, i32u vertexCapacity, i32u indexCapacity);
+    ~MeshArena();
+
+
+    inline GLuint handle() const {
+        return this->id;
+    }
+
+    bool allocate(i32u vertexCount, i32u indexCount, Mesh &mesh);
+    void release(const Mesh &mesh);
+
+    void setVertices(const Mesh &mesh, i32u first, i32u count, const GLvoid *data);
+    void setIndices(const Mesh &mesh, i32u first, i32u count, const GLvoid *data);
+
+    inline bool isConfigured() const {
+        return this->configured;
+    }
+
+    // attribute locations are taken from the program reflection
+    template<typename Format>
+    void setup(const ShaderProgram &program) {
+        if (Format::stride() != this->vertexStride) {
+            fprintf(stderr, "ERROR: Vertex format stride %d does not match the arena stride %d\n", Format::stride(), this->vertexStride);
+            return;
+        }
+        setupVertexAttributes(this->id, this->vertices, 0, this->vertexStride, Format::attributes(), Format::count, VERTEX_INTERLEAVED, program);
+        this->configured = true;
+    }
+
+    // sources more attributes from another buffer, usually per instance
+    template<typename VB>
+    void attach(const VB &buffer, const ShaderProgram &program, GLuint binding, GLuint divisor = 0) {
+        buffer.setup(this->id, program, binding, divisor);
+    }
+
+    void flush();
+    void bind();
+    void draw(const Mesh &mesh, GLenum mode = GL_TRIANGLES);
+
+
+    static i32u getGLIndexSize(GLenum type);
+};
+
+
+#endif //__ARENA_H_INCLUDE__
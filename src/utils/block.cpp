@@ -0,0 +1,284 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+static inline i32u roundUp(i32u value, i32u alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+
+BlockLayout::BlockLayout(Packing packing) : packing(packing), size(0), alignment(packing == STD140 ? 16 : 4) {
+}
+
+BlockLayout::BlockLayout(const ShaderProgram &program, const string &blockName) : packing(STD140), size(0), alignment(16) {
+    const ShaderProgram::UniformBlock &block(program.uniformBlock(blockName));
+    set<string> names(program.uniformNames());
+
+    if (block.index == GL_INVALID_INDEX) {
+        fprintf(stderr, "ERROR: uniform block %s not found!\n", blockName.c_str());
+        return;
+    }
+
+    for (auto it = names.begin(); it != names.end(); it++) {
+        const ShaderProgram::Uniform &uniform(program.uniform(*it));
+
+        if (uniform.blockName != blockName) {
+            continue;
+        }
+
+        Member member = {
+            uniform.name,
+            uniform.type,
+            uniform.size,
+            uniform.blockOffset,
+            uniform.arrayStride,
+            uniform.matrixStride,
+            uniform.rowMajor
+        };
+
+        // arrays are reported as "name[0]", accept the bare name as well
+        if (member.name.size() > 3 && member.name.compare(member.name.size() - 3, 3, "[0]") == 0) {
+            member.name.resize(member.name.size() - 3);
+        }
+        this->insert(member);
+    }
+    this->size = block.size;
+}
+
+
+void BlockLayout::insert(const Member &member) {
+    this->indices[member.name] = this->members.size();
+    this->members.push_back(member);
+}
+
+// arrays and matrices are laid out as arrays of vectors, std140 rounds every
+// array element up to a vec4 while std430 keeps the element alignment
+void BlockLayout::add(const string &name, GLenum type, GLint count, bool rowMajor) {
+    i32u columns = 0;
+    i32u rows = 0;
+
+    if (!BlockLayout::getGLTypeShape(type, columns, rows)) {
+        fprintf(stderr, "ERROR: unsupported type for block member %s!\n", name.c_str());
+        return;
+    }
+
+    Member member = {
+        name,
+        type,
+        _max(count, 1),
+        0,
+        0,
+        0,
+        rowMajor
+    };
+    i32u align = 0;
+    i32u bytes = 0;
+
+    if (columns == 1) {
+        align = rows == 1 ? 4 : (rows == 2 ? 8 : 16);
+        bytes = rows * sizeof(f32);
+        if (count > 1) {
+            align = this->packing == STD140 ? roundUp(align, 16) : align;
+            member.arrayStride = roundUp(bytes, align);
+        }
+    } else {
+        i32u vectors = rowMajor ? rows : columns;
+        i32u components = rowMajor ? columns : rows;
+
+        member.matrixStride = this->packing == STD140 ? 16 : (components == 2 ? 8 : 16);
+        align = member.matrixStride;
+        bytes = vectors * member.matrixStride;
+        if (count > 1) {
+            member.arrayStride = bytes;
+        }
+    }
+
+    member.offset = roundUp(this->size, align);
+    this->size = member.offset + (count > 1 ? member.arrayStride * count : bytes);
+    this->alignment = _max(this->alignment, align);
+    this->insert(member);
+}
+
+i32 BlockLayout::memberIndex(const string &name) const {
+    auto it = this->indices.find(name);
+
+    if (it == this->indices.end()) {
+        return -1;
+    }
+    return (*it).second;
+}
+
+i32u BlockLayout::getSize() const {
+    return roundUp(this->size, this->alignment);
+}
+
+// columns x rows of the 4-byte scalar types that can live in a block
+bool BlockLayout::getGLTypeShape(GLenum type, i32u &columns, i32u &rows) {
+    columns = 1;
+    switch (type) {
+        case GL_FLOAT:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_BOOL:
+            rows = 1;
+            return true;
+
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_BOOL_VEC2:
+            rows = 2;
+            return true;
+
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_BOOL_VEC3:
+            rows = 3;
+            return true;
+
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT_VEC4:
+        case GL_BOOL_VEC4:
+            rows = 4;
+            return true;
+
+        case GL_FLOAT_MAT2:
+            columns = 2;
+            rows = 2;
+            return true;
+
+        case GL_FLOAT_MAT2x3:
+            columns = 2;
+            rows = 3;
+            return true;
+
+        case GL_FLOAT_MAT2x4:
+            columns = 2;
+            rows = 4;
+            return true;
+
+        case GL_FLOAT_MAT3x2:
+            columns = 3;
+            rows = 2;
+            return true;
+
+        case GL_FLOAT_MAT3:
+            columns = 3;
+            rows = 3;
+            return true;
+
+        case GL_FLOAT_MAT3x4:
+            columns = 3;
+            rows = 4;
+            return true;
+
+        case GL_FLOAT_MAT4x2:
+            columns = 4;
+            rows = 2;
+            return true;
+
+        case GL_FLOAT_MAT4x3:
+            columns = 4;
+            rows = 3;
+            return true;
+
+        case GL_FLOAT_MAT4:
+            columns = 4;
+            rows = 4;
+            return true;
+    }
+    rows = 0;
+    return false;
+}
+
+
+BlockWriter::BlockWriter(const BlockLayout &layout, GLenum target) : layout(layout), target(target), alignment(16), stride(0), count(0), base(0) {
+    GLint alignment = 0;
+
+    glGetIntegerv(
+        target == GL_SHADER_STORAGE_BUFFER ? GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT : GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+        &alignment
+    );
+    this->alignment = _max(alignment, 16);
+    this->stride = roundUp(_max(layout.getSize(), (i32u)16), this->alignment);
+}
+
+
+bool BlockWriter::check(const BlockLayout::Member &member, i32u index, i32u columns, i32u rows) const {
+    i32u memberColumns = 0;
+    i32u memberRows = 0;
+
+    if (!BlockLayout::getGLTypeShape(member.type, memberColumns, memberRows) || memberColumns != columns || memberRows != rows) {
+        fprintf(stderr, "ERROR: value does not match the type of block member %s!\n", member.name.c_str());
+        return false;
+    }
+    if (index >= (i32u)_max(member.size, 1)) {
+        fprintf(stderr, "ERROR: index %u out of range for block member %s!\n", index, member.name.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BlockWriter::clear() {
+    this->count = 0;
+}
+
+i32u BlockWriter::append() {
+    i32u slice = this->count++;
+
+    if (this->data.size() < this->count * this->stride) {
+        this->data.resize(this->count * this->stride);
+    }
+    memset(this->data.data() + slice * this->stride, 0, this->stride);
+    return slice;
+}
+
+// regions only grow, so a steady scene keeps streaming through the same ring
+void BlockWriter::upload() {
+    i32u size = this->count * this->stride;
+
+    if (this->count == 0) {
+        return;
+    }
+    if (!this->buffer || this->buffer->getRegionSize() < size) {
+        this->buffer.reset(new StreamingBuffer(this->target, this->data.size()));
+    }
+
+    this->buffer->beginFrame();
+
+    GLvoid *dst = this->buffer->allocate(size, this->alignment, this->base);
+
+    if (dst != NULL) {
+        memcpy(dst, this->data.data(), size);
+    }
+    this->buffer->endFrame();
+}
+
+void BlockWriter::bind(i32u slice, GLuint binding) {
+    if (this->buffer && slice < this->count) {
+        this->buffer->bindRange(binding, this->base + slice * this->stride, this->stride);
+    }
+}
@@ -0,0 +1,167 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __BLOCK_H_INCLUDE__
+#define __BLOCK_H_INCLUDE__
+
+
+// byte layout of an interface block, either read back from program
+// reflection or computed with the std140 / std430 packing rules
+class BlockLayout {
+public:
+    enum Packing {
+        STD140,
+        STD430
+    };
+
+    typedef struct {
+        string name;
+        GLenum type;
+        GLint size;
+        GLint offset;
+        GLint arrayStride;
+        GLint matrixStride;
+        bool rowMajor;
+    } Member;
+
+
+protected:
+    Packing packing;
+    vector<Member> members;
+    map<string, i32u> indices;
+    i32u size;
+    i32u alignment;
+
+
+    void insert(const Member &member);
+
+
+public:
+    BlockLayout(Packing packing = STD140);
+    BlockLayout(const ShaderProgram &program, const string &blockName);
+
+
+    void add(const string &name, GLenum type, GLint count = 1, bool rowMajor = false);
+
+    i32 memberIndex(const string &name) const;
+
+    inline const Member & member(i32u index) const {
+        return this->members[index];
+    }
+
+    inline i32u memberCount() const {
+        return this->members.size();
+    }
+
+    i32u getSize() const;
+
+
+    static bool getGLTypeShape(GLenum type, i32u &columns, i32u &rows);
+};
+
+
+// packs one slice per draw into a single buffer, copied once per frame into
+// a streaming region and selected with glBindBufferRange before each draw
+class BlockWriter {
+protected:
+    BlockLayout layout;
+    GLenum target;
+    i32u alignment;
+    i32u stride;
+    i32u count;
+    vector<i8u> data;
+    shared_ptr<StreamingBuffer> buffer;
+    i32u base;
+
+
+    bool check(const BlockLayout::Member &member, i32u index, i32u columns, i32u rows) const;
+
+    inline i8u * address(i32u slice, const BlockLayout::Member &member, i32u index) {
+        return this->data.data() + slice * this->stride + member.offset + index * member.arrayStride;
+    }
+
+
+public:
+    BlockWriter(const BlockLayout &layout, GLenum target = GL_UNIFORM_BUFFER);
+
+
+    inline const BlockLayout & getLayout() const {
+        return this->layout;
+    }
+
+    inline i32u getStride() const {
+        return this->stride;
+    }
+
+    inline i32u getCount() const {
+        return this->count;
+    }
+
+
+    void clear();
+    i32u append();
+
+    void upload();
+    void bind(i32u slice, GLuint binding);
+
+
+    template<typename VT>
+    void set(i32u slice, i32u member, const VT &value, i32u index = 0) {
+        const BlockLayout::Member &m(this->layout.member(member));
+
+        if (!GLUniformType<VT>::accepts(m.type) || !this->check(m, index, 1, sizeof(VT) / 4)) {
+            return;
+        }
+        memcpy(this->address(slice, m, index), &value, sizeof(VT));
+    }
+
+    template<int rows, int columns>
+    void set(i32u slice, i32u member, const Matrix<f32, rows, columns> &value, i32u index = 0) {
+        const BlockLayout::Member &m(this->layout.member(member));
+
+        if (!this->check(m, index, columns, rows)) {
+            return;
+        }
+
+        i8u *dst = this->address(slice, m, index);
+
+        for (int i = rows - 1; i >= 0; i--) {
+            for (int j = columns - 1; j >= 0; j--) {
+                i32u offset = m.rowMajor ? i * m.matrixStride + j * sizeof(f32) : j * m.matrixStride + i * sizeof(f32);
+
+                memcpy(dst + offset, &value[i][j], sizeof(f32));
+            }
+        }
+    }
+
+    template<typename VT>
+    inline void set(i32u slice, const string &name, const VT &value, i32u index = 0) {
+        i32 member = this->layout.memberIndex(name);
+
+        if (member >= 0) {
+            this->set(slice, (i32u)member, value, index);
+        }
+    }
+};
+
+
+#endif //__BLOCK_H_INCLUDE__
@@ -24,37 +24,83 @@
 
 
 Buffer::Buffer(GLenum target, i32u size, const GLvoid *data, GLenum usage) : id(GL_ZERO), enabled(0), target(target), size(size), usage(usage) {
+    if (GLState::directStateAccess()) {
+        glCreateBuffers(1, &this->id);
+        if (this->id != GL_ZERO && this->size > 0) {
+            glNamedBufferData(this->id, this->size, data, this->usage);
+        }
+        return;
+    }
+
     glGenBuffers(1, &this->id);
     if (this->id == GL_ZERO) {
         return;
     }
 
     if (this->size > 0) {
-        glBindBuffer(this->target, this->id);
-        glBufferData(this->target, this->size, data, this->usage);
-        glBindBuffer(this->target, GL_ZERO);
+        GLState::bindBuffer(this->editTarget(), this->id);
+        glBufferData(this->editTarget(), this->size, data, this->usage);
+        GLState::unbindBuffer(this->editTarget());
+    }
+}
+
+Buffer::Buffer(GLenum target, i32u size, GLbitfield storageFlags, const GLvoid *data, GLenum usage) : id(GL_ZERO), enabled(0), target(target), size(size), usage(storageFlags != 0 ? GL_ZERO : usage) {
+    if (GLState::directStateAccess()) {
+        glCreateBuffers(1, &this->id);
+        if (this->id != GL_ZERO && this->size > 0) {
+            if (storageFlags != 0) {
+                glNamedBufferStorage(this->id, this->size, data, storageFlags);
+            } else {
+                glNamedBufferData(this->id, this->size, data, this->usage);
+            }
+        }
+        return;
+    }
+
+    glGenBuffers(1, &this->id);
+    if (this->id == GL_ZERO) {
+        return;
+    }
+
+    if (this->size > 0) {
+        GLState::bindBuffer(this->editTarget(), this->id);
+        if (storageFlags != 0) {
+            glBufferStorage(this->editTarget(), this->size, data, storageFlags);
+        } else {
+            glBufferData(this->editTarget(), this->size, data, this->usage);
+        }
+        GLState::unbindBuffer(this->editTarget());
     }
 }
 
 Buffer::Buffer(const Buffer &buffer) : id(GL_ZERO), enabled(0), target(buffer.target), size(buffer.size), usage(buffer.usage) {
+    if (GLState::directStateAccess()) {
+        glCreateBuffers(1, &this->id);
+        if (this->id != GL_ZERO && buffer.id != GL_ZERO && this->size > 0) {
+            glNamedBufferData(this->id, this->size, NULL, this->usage);
+            glCopyNamedBufferSubData(buffer.id, this->id, 0, 0, this->size);
+        }
+        return;
+    }
+
     glGenBuffers(1, &this->id);
     if (this->id == GL_ZERO || buffer.id == GL_ZERO) {
         return;
     }
 
     if (this->size > 0) {
-        glBindBuffer(GL_COPY_READ_BUFFER, buffer.id);
-        glBindBuffer(GL_COPY_WRITE_BUFFER, this->id);
+        GLState::bindBuffer(GL_COPY_READ_BUFFER, buffer.id);
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, this->id);
         glBufferData(GL_COPY_WRITE_BUFFER, this->size, NULL, this->usage);
         glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, this->size);
-        glBindBuffer(GL_COPY_WRITE_BUFFER, GL_ZERO);
-        glBindBuffer(GL_COPY_READ_BUFFER, GL_ZERO);
+        GLState::unbindBuffer(GL_COPY_WRITE_BUFFER);
+        GLState::unbindBuffer(GL_COPY_READ_BUFFER);
     }
 }
 
 Buffer::~Buffer() {
     if (this->id != GL_ZERO) {
-        glDeleteBuffers(1, &this->id);
+        GLState::deleteBuffer(this->id);
     }
 }
 
@@ -63,7 +109,7 @@ void Buffer::enable() {
         if (this->id == GL_ZERO) {
             return;
         }
-        glBindBuffer(this->target, this->id);
+        GLState::bindBuffer(this->target, this->id);
     }
     this->enabled++;
 }
@@ -71,27 +117,51 @@ void Buffer::enable() {
 void Buffer::disable() {
     this->enabled--;
     if (this->enabled == 0) {
-        glBindBuffer(this->target, GL_ZERO);
+        GLState::unbindBuffer(this->target);
     }
 }
 
 void Buffer::getData(i32u offset, i32u size, GLvoid *data) {
-    this->enable();
-
-    glGetBufferSubData(this->target, offset, size, data);
+    if (GLState::directStateAccess()) {
+        glGetNamedBufferSubData(this->id, offset, size, data);
+        return;
+    }
 
-    this->disable();
+    GLState::bindBuffer(this->editTarget(), this->id);
+    glGetBufferSubData(this->editTarget(), offset, size, data);
+    GLState::unbindBuffer(this->editTarget());
 }
 
 void Buffer::setData(i32u offset, i32u size, const GLvoid *data) {
-    this->enable();
+    if (GLState::directStateAccess()) {
+        glNamedBufferSubData(this->id, offset, size, data);
+        return;
+    }
 
-    glBufferSubData(this->target, offset, size, data);
+    GLState::bindBuffer(this->editTarget(), this->id);
+    glBufferSubData(this->editTarget(), offset, size, data);
+    GLState::unbindBuffer(this->editTarget());
+}
 
-    this->disable();
+void Buffer::bindBase(GLuint index) {
+    if (this->id == GL_ZERO) {
+        return;
+    }
+    GLState::bindBufferBase(this->target, index, this->id);
 }
 
+void Buffer::bindRange(GLuint index, i32u offset, i32u size) {
+    if (this->id == GL_ZERO) {
+        return;
+    }
+    GLState::bindBufferRange(this->target, index, this->id, offset, size);
+}
+
+// with direct state access the buffer does not need to be enabled first
 GLvoid* Buffer::map(i32u access) {
+    if (GLState::directStateAccess()) {
+        return glMapNamedBuffer(this->id, access);
+    }
     if (this->enabled == 0) {
         return NULL;
     }
@@ -99,6 +169,9 @@ GLvoid* Buffer::map(i32u access) {
 }
 
 GLvoid* Buffer::map(i32u offset, i32u size, i32u access) {
+    if (GLState::directStateAccess()) {
+        return glMapNamedBufferRange(this->id, offset, size, access);
+    }
     if (this->enabled == 0) {
         return NULL;
     }
@@ -106,6 +179,10 @@ GLvoid* Buffer::map(i32u offset, i32u size, i32u access) {
 }
 
 void Buffer::flush(i32u offset, i32u size) {
+    if (GLState::directStateAccess()) {
+        glFlushMappedNamedBufferRange(this->id, offset, size);
+        return;
+    }
     if (this->enabled == 0) {
         return;
     }
@@ -113,8 +190,209 @@ void Buffer::flush(i32u offset, i32u size) {
 }
 
 void Buffer::unmap() {
+    if (GLState::directStateAccess()) {
+        glUnmapNamedBuffer(this->id);
+        return;
+    }
     if (this->enabled == 0) {
         return;
     }
     glUnmapBuffer(this->target);
 }
+
+
+ShadowedBuffer::ShadowedBuffer(GLenum target, i32u size, GLenum usage) : Buffer(target, size, NULL, usage), shadow(size) {
+}
+
+ShadowedBuffer::ShadowedBuffer(const ShadowedBuffer &buffer) : Buffer(buffer), shadow(buffer.shadow), dirty(buffer.dirty) {
+}
+
+ShadowedBuffer::~ShadowedBuffer() {
+}
+
+// sequential edits extend the last range in place, anything else is
+// sorted out by flush()
+void ShadowedBuffer::markDirty(i32u begin, i32u end) {
+    if (!this->dirty.empty()) {
+        pair<i32u, i32u> &last(this->dirty.back());
+
+        if (begin >= last.first && begin <= last.second) {
+            last.second = _max(last.second, end);
+            return;
+        }
+    }
+    this->dirty.push_back(make_pair(begin, end));
+}
+
+void ShadowedBuffer::write(i32u offset, i32u size, const GLvoid *data) {
+    if (offset + size > this->shadow.size()) {
+        fprintf(stderr, "ERROR: write of %u bytes at %u overflows buffer of %u bytes!\n", size, offset, (i32u)this->shadow.size());
+        return;
+    }
+    memcpy(this->shadow.data() + offset, data, size);
+    this->markDirty(offset, offset + size);
+}
+
+i32u ShadowedBuffer::flush() {
+    i32u uploads = 0;
+
+    if (this->dirty.empty()) {
+        return uploads;
+    }
+
+    sort(this->dirty.begin(), this->dirty.end());
+
+    auto range = this->dirty.begin();
+    i32u begin = (*range).first;
+    i32u end = (*range).second;
+
+    for (range++; range != this->dirty.end(); range++) {
+        if ((*range).first <= end + ShadowedBuffer::coalesceGap) {
+            end = _max(end, (*range).second);
+            continue;
+        }
+        Buffer::setData(begin, end - begin, this->shadow.data() + begin);
+        uploads++;
+        begin = (*range).first;
+        end = (*range).second;
+    }
+    Buffer::setData(begin, end - begin, this->shadow.data() + begin);
+    uploads++;
+
+    this->dirty.clear();
+    return uploads;
+}
+
+void ShadowedBuffer::getData(i32u offset, i32u size, GLvoid *data) {
+    if (offset + size > this->shadow.size()) {
+        return;
+    }
+    memcpy(data, this->shadow.data() + offset, size);
+}
+
+void ShadowedBuffer::setData(i32u offset, i32u size, const GLvoid *data) {
+    if (offset + size > this->shadow.size()) {
+        return;
+    }
+    memcpy(this->shadow.data() + offset, data, size);
+    Buffer::setData(offset, size, data);
+}
+
+
+StreamingBuffer::StreamingBuffer(GLenum target, i32u regionSize, i32u regions) : Buffer(
+    target,
+    regionSize * regions,
+    StreamingBuffer::persistentMapping() ? (GLbitfield)(GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) : (GLbitfield)GL_ZERO,
+    NULL,
+    GL_STREAM_DRAW
+), regions(regions), regionSize(regionSize), persistent(StreamingBuffer::persistentMapping()), region(regions - 1), head(0), mapping(NULL), fences(regions, (GLsync)NULL), stalls(0) {
+    if (!this->persistent) {
+        return;
+    }
+
+    this->enable();
+    this->mapping = reinterpret_cast<i8u *>(this->map(0, this->size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    this->disable();
+    if (this->mapping == NULL) {
+        fprintf(stderr, "ERROR: Cannot map streaming buffer!\n");
+    }
+}
+
+StreamingBuffer::~StreamingBuffer() {
+    for (auto it = this->fences.begin(); it != this->fences.end(); it++) {
+        if ((*it) != NULL) {
+            glDeleteSync(*it);
+        }
+    }
+    if (this->mapping != NULL) {
+        this->enable();
+        this->unmap();
+        this->disable();
+    }
+}
+
+// GL 4.4 or ARB_buffer_storage, the storage stays mapped for its whole life
+bool StreamingBuffer::persistentMapping() {
+    static i32 supported = -1;
+
+    if (supported < 0) {
+        supported = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage ? 1 : 0;
+    }
+    return supported > 0;
+}
+
+void StreamingBuffer::waitRegion(i32u region) {
+    GLsync fence = this->fences[region];
+
+    if (fence == NULL) {
+        return;
+    }
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        this->stalls++;
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+        }
+    }
+    glDeleteSync(fence);
+    this->fences[region] = NULL;
+}
+
+// the previous region gets its fence here, after every draw reading it was
+// issued, then the next region is waited for
+void StreamingBuffer::beginFrame() {
+    if (this->persistent) {
+        this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    this->region = (this->region + 1) % this->regions;
+    this->head = 0;
+
+    if (this->persistent) {
+        this->waitRegion(this->region);
+        return;
+    }
+
+    this->enable();
+    if (this->region == 0) {
+        if (GLState::directStateAccess()) {
+            glNamedBufferData(this->handle(), this->size, NULL, this->usage);
+        } else {
+            glBufferData(this->target, this->size, NULL, this->usage);
+        }
+    }
+    this->mapping = reinterpret_cast<i8u *>(this->map(
+        this->region * this->regionSize,
+        this->regionSize,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT
+    ));
+    this->disable();
+}
+
+// returns NULL when the region is full, offset is relative to the buffer
+GLvoid * StreamingBuffer::allocate(i32u size, i32u alignment, i32u &offset) {
+    i32u start = (this->head + alignment - 1) / alignment * alignment;
+
+    if (this->mapping == NULL || start + size > this->regionSize) {
+        return NULL;
+    }
+    this->head = start + size;
+    offset = this->region * this->regionSize + start;
+    if (this->persistent) {
+        return this->mapping + offset;
+    }
+    return this->mapping + start;
+}
+
+// must be called before any draw sources the region
+void StreamingBuffer::endFrame() {
+    if (this->persistent || this->mapping == NULL) {
+        return;
+    }
+
+    this->enable();
+    if (this->head > 0) {
+        this->flush(0, this->head);
+    }
+    this->unmap();
+    this->disable();
+    this->mapping = NULL;
+}
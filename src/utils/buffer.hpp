@@ -31,6 +31,16 @@ private:
 
 
 protected:
+    // immutable storage when flags are given, the usage only applies to the
+    // mutable storage of contexts without buffer storage
+    Buffer(GLenum target, i32u size, GLbitfield storageFlags, const GLvoid *data, GLenum usage);
+
+    // the element binding belongs to the bound vertex array, edits go
+    // through the copy target so they never replace it
+    inline GLenum editTarget() const {
+        return this->target == GL_ELEMENT_ARRAY_BUFFER ? GL_COPY_WRITE_BUFFER : this->target;
+    }
+
     virtual GLvoid * map(i32u access);
     virtual GLvoid * map(i32u offset, i32u size, i32u access);
     void flush(i32u offset, i32u size);
@@ -48,258 +58,168 @@ public:
     virtual ~Buffer();
 
 
+    inline GLuint handle() const {
+        return this->id;
+    }
+
+
     virtual void enable();
     virtual void disable();
 
     virtual void getData(i32u offset, i32u size, GLvoid *data);
     virtual void setData(i32u offset, i32u size, const GLvoid *data);
-};
 
+    virtual void bindBase(GLuint index);
+    virtual void bindRange(GLuint index, i32u offset, i32u size);
+};
 
-class VertexAttributeBuffer : public Buffer {
-public:
-    const i32u vertexCount;
-    const i32u stride;
 
+// keeps a CPU copy of the whole buffer, edits only touch the copy and
+// flush() uploads the dirty ranges, merged when they are close enough
+class ShadowedBuffer : public Buffer {
+protected:
+    vector<i8u> shadow;
+    vector<pair<i32u, i32u> > dirty;
 
-    VertexAttributeBuffer(i32u vertexCount, i32u stride, GLenum usage = GL_STATIC_DRAW) : Buffer(GL_ARRAY_BUFFER, vertexCount * stride, NULL, usage), vertexCount(vertexCount), stride(stride) {
-    }
 
-    VertexAttributeBuffer(const VertexAttributeBuffer &buffer) : Buffer(buffer), vertexCount(buffer.vertexCount), stride(buffer.stride) {
-    }
+    using Buffer::flush;
 
-    virtual ~VertexAttributeBuffer() {
-    }
-};
+    void markDirty(i32u begin, i32u end);
 
 
-template<typename VT, int vertexCoords>
-class VertexAttributeBufferV : public VertexAttributeBuffer {
 public:
-    typedef Vector<VT, vertexCoords> V;
+    // gap in bytes below which two dirty ranges are uploaded as one
+    static const i32u coalesceGap = 4096;
 
 
-    VertexAttributeBufferV(i32u vertexCount, GLenum usage = GL_STATIC_DRAW) : VertexAttributeBuffer(
-        vertexCount,
-        vertexCoords * sizeof(VT),
-        usage
-    ) { }
+    ShadowedBuffer(GLenum target, i32u size, GLenum usage = GL_STATIC_DRAW);
+    ShadowedBuffer(const ShadowedBuffer &buffer);
+    virtual ~ShadowedBuffer();
 
-    VertexAttributeBufferV(const VertexAttributeBufferV &buffer) : VertexAttributeBuffer(buffer) {
-    }
 
-    virtual ~VertexAttributeBufferV() { }
+    void write(i32u offset, i32u size, const GLvoid *data);
 
-
-    virtual void setVertex(i32u vertexOffset, const V &vertex) {
-        this->enable();
-        vertexOffset *= this->stride;
-        this->setData(vertexOffset, this->stride, vertex);
-        // vertexOffset += this->stride;
-        this->disable();
-    }
-    virtual void setVertices(i32u vertexOffset, const vector<V> &data) {
-        this->enable();
-        vertexOffset *= this->stride;
-        for_each(data.begin(), data.end(), [&] (const V &vertex) {
-            this->setData(vertexOffset, this->stride, vertex);
-            vertexOffset += this->stride;
-        });
-        this->disable();
+    inline bool isDirty() const {
+        return !this->dirty.empty();
     }
-};
 
+    i32u flush();
 
-template<typename VT, int vertexCoords, typename NT, int normalCoords>
-class VertexAttributeBufferVN : public VertexAttributeBuffer {
-public:
-    typedef Vector<VT, vertexCoords> V;
-    typedef Vector<NT, normalCoords> N;
+    virtual void getData(i32u offset, i32u size, GLvoid *data);
+    virtual void setData(i32u offset, i32u size, const GLvoid *data);
+};
 
-    typedef struct {
-        V position;
-        N normal;
-    } Vertex;
 
+class VertexAttributeBuffer : public ShadowedBuffer {
+public:
+    const i32u vertexCount;
+    const i32u stride;
 
-    VertexAttributeBufferVN(i32u vertexCount, GLenum usage = GL_STATIC_DRAW) : VertexAttributeBuffer(
-        vertexCount,
-        vertexCoords * sizeof(VT) + normalCoords * sizeof(NT),
-        usage
-    ) { }
 
-    VertexAttributeBufferVN(const VertexAttributeBufferVN &buffer) : VertexAttributeBuffer(buffer) {
+    VertexAttributeBuffer(i32u vertexCount, i32u stride, GLenum usage = GL_STATIC_DRAW) : ShadowedBuffer(GL_ARRAY_BUFFER, vertexCount * stride, usage), vertexCount(vertexCount), stride(stride) {
     }
 
-    virtual ~VertexAttributeBufferVN() { }
-
-
-    virtual void setVertex(i32u vertexOffset, const Vertex &vertex) {
-        this->enable();
-        vertexOffset *= this->stride;
-        this->setData(vertexOffset, vertexCoords * sizeof(VT), vertex.position);
-        vertexOffset += vertexCoords * sizeof(VT);
-        this->setData(vertexOffset, normalCoords * sizeof(NT), vertex.normal);
-        // vertexOffset += normalCoords * sizeof(NT);
-        this->disable();
+    VertexAttributeBuffer(const VertexAttributeBuffer &buffer) : ShadowedBuffer(buffer), vertexCount(buffer.vertexCount), stride(buffer.stride) {
     }
-    virtual void setVertices(i32u vertexOffset, const vector<Vertex> &data) {
-        this->enable();
-        vertexOffset *= this->stride;
-        for_each(data.begin(), data.end(), [&] (const Vertex &vertex) {
-            this->setData(vertexOffset, vertexCoords * sizeof(VT), vertex.position);
-            vertexOffset += vertexCoords * sizeof(VT);
-            this->setData(vertexOffset, normalCoords * sizeof(NT), vertex.normal);
-            vertexOffset += normalCoords * sizeof(NT);
-        });
-        this->disable();
+
+    virtual ~VertexAttributeBuffer() {
     }
 };
 
 
-template<typename VT, int vertexCoords, typename NT, int normalCoords, typename CT, int colorCoords>
-class VertexAttributeBufferVNC : public VertexAttributeBuffer {
+template<typename IT, int vertexCount>
+class ElementBuffer : public ShadowedBuffer {
 public:
-    typedef Vector<VT, vertexCoords> V;
-    typedef Vector<NT, normalCoords> N;
-    typedef Vector<CT, colorCoords> C;
-
     typedef struct {
-        V position;
-        N normal;
-        C color;
-    } Vertex;
+        IT indices[vertexCount];
+    } F;
 
+    static_assert(sizeof(F) == vertexCount * sizeof(IT), "face type must be tightly packed");
 
-    VertexAttributeBufferVNC(i32u vertexCount, GLenum usage = GL_STATIC_DRAW) : VertexAttributeBuffer(
-        vertexCount,
-        vertexCoords * sizeof(VT) + normalCoords * sizeof(NT) + colorCoords * sizeof(CT),
-        usage
-    ) { }
 
-    VertexAttributeBufferVNC(const VertexAttributeBufferVNC &buffer) : VertexAttributeBuffer(buffer) {
-    }
+    const i32u faceCount;
+    const i32u stride;
 
-    virtual ~VertexAttributeBufferVNC() { }
 
+    ElementBuffer(i32u faceCount, GLenum usage = GL_STATIC_DRAW) : ShadowedBuffer(GL_ELEMENT_ARRAY_BUFFER, faceCount * vertexCount * sizeof(IT), usage), faceCount(faceCount), stride(vertexCount * sizeof(IT)) {
+    }
 
-    virtual void setVertex(i32u vertexOffset, const Vertex &vertex) {
-        this->enable();
-        vertexOffset *= this->stride;
-        this->setData(vertexOffset, vertexCoords * sizeof(VT), vertex.position);
-        vertexOffset += vertexCoords * sizeof(VT);
-        this->setData(vertexOffset, normalCoords * sizeof(NT), vertex.normal);
-        vertexOffset += normalCoords * sizeof(NT);
-        this->setData(vertexOffset, colorCoords * sizeof(CT), vertex.color);
-        // vertexOffset += colorCoords * sizeof(CT);
-        this->disable();
+    ElementBuffer(const ElementBuffer &buffer) : ShadowedBuffer(buffer), faceCount(buffer.faceCount), stride(buffer.stride) {
     }
-    virtual void setVertices(i32u vertexOffset, const vector<Vertex> &data) {
-        this->enable();
-        vertexOffset *= this->stride;
-        for_each(data.begin(), data.end(), [&] (const Vertex &vertex) {
-            this->setData(vertexOffset, vertexCoords * sizeof(VT), vertex.position);
-            vertexOffset += vertexCoords * sizeof(VT);
-            this->setData(vertexOffset, normalCoords * sizeof(NT), vertex.normal);
-            vertexOffset += normalCoords * sizeof(NT);
-            this->setData(vertexOffset, colorCoords * sizeof(CT), vertex.color);
-            vertexOffset += colorCoords * sizeof(CT);
-        });
-        this->disable();
+
+    virtual ~ElementBuffer() {
     }
-};
 
 
-template<typename VT, int vertexCoords, typename NT, int normalCoords, typename TT, int textureCoords>
-class VertexAttributeBufferVNT : public VertexAttributeBuffer {
-public:
-    typedef Vector<VT, vertexCoords>  V;
-    typedef Vector<NT, normalCoords>  N;
-    typedef Vector<TT, textureCoords> T;
+    virtual void setFace(i32u faceOffset, const F &face) {
+        faceOffset *= this->stride;
+        this->write(faceOffset, this->stride, face.indices);
+        // faceOffset += this->stride;
+    }
+    virtual void setFaces(i32u faceOffset, const vector<F> &data) {
+        this->write(faceOffset * this->stride, data.size() * this->stride, data.data());
+    }
+};
 
-    typedef struct {
-        V position;
-        N normal;
-        T texture;
-    } Vertex;
 
+// ring of frame regions written through a mapping, each region is fenced
+// once its frame has been submitted and only reused when the fence passed;
+// contexts without buffer storage orphan the buffer when the ring wraps
+// and map each region unsynchronized instead
+class StreamingBuffer : public Buffer {
+protected:
+    const i32u regions;
+    const i32u regionSize;
+    const bool persistent;
+    i32u region;
+    i32u head;
+    i8u *mapping;
+    vector<GLsync> fences;
+    i64u stalls;
 
-    VertexAttributeBufferVNT(i32u vertexCount, GLenum usage = GL_STATIC_DRAW) : VertexAttributeBuffer(
-        vertexCount,
-        vertexCoords * sizeof(VT) + normalCoords * sizeof(NT) + textureCoords * sizeof(TT),
-        usage
-    ) { }
 
-    VertexAttributeBufferVNT(const VertexAttributeBufferVNT &buffer) : VertexAttributeBuffer(buffer) {
-    }
+    void waitRegion(i32u region);
 
-    virtual ~VertexAttributeBufferVNT() { }
 
+public:
+    static const i32u defaultRegions = 3;
 
-    virtual void setVertex(i32u vertexOffset, const Vertex &vertex) {
-        this->enable();
-        vertexOffset *= this->stride;
-        this->setData(vertexOffset, vertexCoords * sizeof(VT), vertex.position);
-        vertexOffset += vertexCoords * sizeof(VT);
-        this->setData(vertexOffset, normalCoords * sizeof(NT), vertex.normal);
-        vertexOffset += normalCoords * sizeof(NT);
-        this->setData(vertexOffset, textureCoords * sizeof(TT), vertex.texture);
-        // vertexOffset += textureCoords * sizeof(TT);
-        this->disable();
-    }
-    virtual void setVertices(i32u vertexOffset, const vector<Vertex> &data) {
-        this->enable();
-        vertexOffset *= this->stride;
-        for_each(data.begin(), data.end(), [&] (const Vertex &vertex) {
-            this->setData(vertexOffset, vertexCoords * sizeof(VT), vertex.position);
-            vertexOffset += vertexCoords * sizeof(VT);
-            this->setData(vertexOffset, normalCoords * sizeof(NT), vertex.normal);
-            vertexOffset += normalCoords * sizeof(NT);
-            this->setData(vertexOffset, textureCoords * sizeof(TT), vertex.texture);
-            vertexOffset += textureCoords * sizeof(TT);
-        });
-        this->disable();
-    }
-};
 
+    StreamingBuffer(GLenum target, i32u regionSize, i32u regions = StreamingBuffer::defaultRegions);
+    // the mapping and the fences belong to one buffer only
+    StreamingBuffer(const StreamingBuffer &buffer) = delete;
+    virtual ~StreamingBuffer();
 
-template<typename IT, int vertexCount>
-class ElementBuffer : public Buffer {
-public:
-    typedef struct {
-        IT indices[vertexCount];
-    } F;
 
+    StreamingBuffer & operator =(const StreamingBuffer &buffer) = delete;
 
-    const i32u faceCount;
-    const i32u stride;
 
+    void beginFrame();
+    GLvoid * allocate(i32u size, i32u alignment, i32u &offset);
+    void endFrame();
 
-    ElementBuffer(i32u faceCount, GLenum usage = GL_STATIC_DRAW) : Buffer(GL_ELEMENT_ARRAY_BUFFER, faceCount * vertexCount * sizeof(IT), NULL, usage), faceCount(faceCount), stride(vertexCount * sizeof(IT)) {
+    inline i32u getRegionSize() const {
+        return this->regionSize;
     }
 
-    ElementBuffer(const ElementBuffer &buffer) : Buffer(buffer), faceCount(buffer.faceCount), stride(buffer.stride) {
+    inline i64u getStalls() const {
+        return this->stalls;
     }
 
-    virtual ~ElementBuffer() {
-    }
 
+    static bool persistentMapping();
+};
 
-    virtual void setFace(i32u faceOffset, const F &face) {
-        this->enable();
-        faceOffset *= this->stride;
-        this->setData(faceOffset, this->stride, face.indices);
-        // faceOffset += this->stride;
-        this->disable();
+
+class UniformBuffer : public Buffer {
+public:
+    UniformBuffer(i32u size, const GLvoid *data = NULL, GLenum usage = GL_DYNAMIC_DRAW) : Buffer(GL_UNIFORM_BUFFER, size, data, usage) {
     }
-    virtual void setFaces(i32u faceOffset, const vector<F> &data) {
-        this->enable();
-        faceOffset *= this->stride;
-        for_each(data.begin(), data.end(), [&] (const F &face) {
-            this->setData(faceOffset, this->stride, face.indices);
-            faceOffset += this->stride;
-        });
-        this->disable();
+
+    UniformBuffer(const UniformBuffer &buffer) : Buffer(buffer) {
+    }
+
+    virtual ~UniformBuffer() {
     }
 };
 
@@ -0,0 +1,254 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+static const i32u cacheMagic = 0x43504641;
+static const i32u cacheVersion = 1;
+
+
+static i64u fnv1a(i64u hash, const void *data, size_t length) {
+    const i8u *bytes = (const i8u *)data;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool makeDirectories(const string &path) {
+    for (size_t i = 1; i <= path.length(); i++) {
+        if (i == path.length() || path[i] == '/') {
+            if (mkdir(path.substr(0, i).c_str(), 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+ProgramCache::ProgramCache() : ProgramCache(ProgramCache::defaultDirectory()) {
+}
+
+ProgramCache::ProgramCache(const string &directory) : directory(directory), supported(false) {
+    const GLubyte *strings[] = {
+        glGetString(GL_VENDOR),
+        glGetString(GL_RENDERER),
+        glGetString(GL_VERSION)
+    };
+    GLint formats = 0;
+
+    for (int i = 0; i < 3; i++) {
+        this->driver += (strings[i] != NULL ? (const char *)strings[i] : "");
+        this->driver += '\n';
+    }
+    if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    this->supported = (formats > 0 && this->directory.length() > 0);
+}
+
+
+i64u ProgramCache::key(const Sources &sources) const {
+    i64u hash = 14695981039346656037ULL;
+
+    hash = fnv1a(hash, this->driver.data(), this->driver.length());
+    for_each(sources.begin(), sources.end(), [&hash] (const pair<GLenum, string> &source) {
+        i32u length = source.second.length();
+
+        hash = fnv1a(hash, &source.first, sizeof(source.first));
+        hash = fnv1a(hash, &length, sizeof(length));
+        hash = fnv1a(hash, source.second.data(), source.second.length());
+    });
+    return hash;
+}
+
+string ProgramCache::path(i64u key) const {
+    char name[32];
+
+    snprintf(name, sizeof(name), "%016llx.bin", key);
+    return this->directory + "/" + name;
+}
+
+shared_ptr<ShaderProgram> ProgramCache::load(i64u key) const {
+    ifstream file(this->path(key), ios::in | ios::binary);
+    i32u magic = 0;
+    i32u version = 0;
+    i64u fileKey = 0;
+
+    if (!file.is_open()) {
+        return shared_ptr<ShaderProgram>();
+    }
+    file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    file.read(reinterpret_cast<char *>(&fileKey), sizeof(fileKey));
+    if (!file || magic != cacheMagic || version != cacheVersion || fileKey != key) {
+        return shared_ptr<ShaderProgram>();
+    }
+    return ShaderProgram::loadBinary(file);
+}
+
+void ProgramCache::save(i64u key, const shared_ptr<ShaderProgram> &program) const {
+    string path(this->path(key));
+    string temporary(path + ".tmp");
+
+    if (!makeDirectories(this->directory)) {
+        fprintf(stderr, "ERROR: Cannot create cache directory %s!\n", this->directory.c_str());
+        return;
+    }
+
+    {
+        ofstream file(temporary, ios::out | ios::binary | ios::trunc);
+
+        file.write(reinterpret_cast<const char *>(&cacheMagic), sizeof(cacheMagic));
+        file.write(reinterpret_cast<const char *>(&cacheVersion), sizeof(cacheVersion));
+        file.write(reinterpret_cast<const char *>(&key), sizeof(key));
+        if (!program->saveBinary(file) || !file.flush()) {
+            file.close();
+            remove(temporary.c_str());
+            return;
+        }
+    }
+
+    // rename keeps concurrent readers from seeing a partial entry
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+    }
+}
+
+
+shared_ptr<ShaderProgram> ProgramCache::program(const Sources &sources, bool deferred) {
+    i64u key = this->key(sources);
+    list<shared_ptr<Shader> > shaders;
+    shared_ptr<ShaderProgram> program;
+
+    if (this->supported) {
+        program = this->load(key);
+        if (program) {
+            return program;
+        }
+    }
+
+    // missing, stale or rejected by the driver: compile from source
+    for_each(sources.begin(), sources.end(), [&shaders, deferred] (const pair<GLenum, string> &source) {
+        shaders.push_back(shared_ptr<Shader>(new Shader(source.first, source.second, deferred)));
+    });
+    program.reset(new ShaderProgram(shaders, deferred));
+    if (this->supported) {
+        if (deferred) {
+            this->pending.push_back(make_pair(key, program));
+        } else if (program->isLinked()) {
+            this->save(key, program);
+        }
+    }
+    return program;
+}
+
+shared_ptr<ShaderProgram> ProgramCache::program(const string &vertexSource, const string &fragmentSource, bool deferred) {
+    Sources sources;
+
+    sources.push_back(make_pair((GLenum)GL_VERTEX_SHADER, vertexSource));
+    sources.push_back(make_pair((GLenum)GL_FRAGMENT_SHADER, fragmentSource));
+    return this->program(sources, deferred);
+}
+
+shared_ptr<ShaderProgram> ProgramCache::programFromFiles(const string &vertexPath, const string &fragmentPath, bool deferred) {
+    return this->program(Shader::readFile(vertexPath), Shader::readFile(fragmentPath), deferred);
+}
+
+// stores deferred programs once the driver has finished linking them
+void ProgramCache::update() {
+    for (auto it = this->pending.begin(); it != this->pending.end(); ) {
+        if ((*it).second->isReady()) {
+            if ((*it).second->isLinked()) {
+                this->save((*it).first, (*it).second);
+            }
+            it = this->pending.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+
+string ProgramCache::defaultDirectory() {
+    const char *cache = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+
+    if (cache != NULL && cache[0] != '\0') {
+        return string(cache) + "/archifake";
+    }
+    if (home != NULL && home[0] != '\0') {
+        return string(home) + "/.cache/archifake";
+    }
+    return "";
+}
+
+
+ShaderVariantCache::ShaderVariantCache(const shared_ptr<ProgramCache> &programCache) : programCache(programCache) {
+}
+
+string ShaderVariantCache::key(const string &vertexPath, const string &fragmentPath, const ShaderPreprocessor::Defines &defines) {
+    string key(vertexPath + "\n" + fragmentPath + "\n");
+
+    // defines are kept sorted by the map, so equal sets give equal keys
+    for (auto it = defines.begin(); it != defines.end(); it++) {
+        key += (*it).first + "=" + (*it).second + "\n";
+    }
+    return key;
+}
+
+shared_ptr<ShaderProgram> ShaderVariantCache::program(const string &vertexPath, const string &fragmentPath, const ShaderPreprocessor::Defines &defines, bool deferred) {
+    string key(ShaderVariantCache::key(vertexPath, fragmentPath, defines));
+    auto it = this->programs.find(key);
+    string vertexSource;
+    string fragmentSource;
+    shared_ptr<ShaderProgram> program;
+
+    if (it != this->programs.end()) {
+        return (*it).second;
+    }
+
+    if (!this->preprocessor.process(vertexPath, defines, vertexSource) || !this->preprocessor.process(fragmentPath, defines, fragmentSource)) {
+        return shared_ptr<ShaderProgram>();
+    }
+    if (this->programCache) {
+        program = this->programCache->program(vertexSource, fragmentSource, deferred);
+    } else {
+        program.reset(
+            new ShaderProgram(
+                shared_ptr<Shader>(new Shader(GL_VERTEX_SHADER, vertexSource, deferred)),
+                shared_ptr<Shader>(new Shader(GL_FRAGMENT_SHADER, fragmentSource, deferred)),
+                deferred
+            )
+        );
+    }
+    this->programs[key] = program;
+    return program;
+}
+
+void ShaderVariantCache::clear() {
+    this->programs.clear();
+}
@@ -0,0 +1,91 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __CACHE_H_INCLUDE__
+#define __CACHE_H_INCLUDE__
+
+
+// on-disk cache of linked program binaries, keyed on the shader sources and
+// the driver identification strings
+class ProgramCache {
+public:
+    typedef list<pair<GLenum, string> > Sources;
+
+
+protected:
+    string directory;
+    string driver;
+    bool supported;
+    list<pair<i64u, shared_ptr<ShaderProgram> > > pending;
+
+
+    i64u key(const Sources &sources) const;
+    string path(i64u key) const;
+
+    shared_ptr<ShaderProgram> load(i64u key) const;
+    void save(i64u key, const shared_ptr<ShaderProgram> &program) const;
+
+
+public:
+    ProgramCache();
+    ProgramCache(const string &directory);
+
+
+    shared_ptr<ShaderProgram> program(const Sources &sources, bool deferred = false);
+    shared_ptr<ShaderProgram> program(const string &vertexSource, const string &fragmentSource, bool deferred = false);
+    shared_ptr<ShaderProgram> programFromFiles(const string &vertexPath, const string &fragmentPath, bool deferred = false);
+
+    void update();
+
+
+    static string defaultDirectory();
+};
+
+
+// programs specialized by a define set, each variant is preprocessed and
+// built once then shared by every surface asking for the same key
+class ShaderVariantCache {
+protected:
+    ShaderPreprocessor preprocessor;
+    shared_ptr<ProgramCache> programCache;
+    map<string, shared_ptr<ShaderProgram> > programs;
+
+
+    static string key(const string &vertexPath, const string &fragmentPath, const ShaderPreprocessor::Defines &defines);
+
+
+public:
+    ShaderVariantCache(const shared_ptr<ProgramCache> &programCache = shared_ptr<ProgramCache>());
+
+
+    inline ShaderPreprocessor & getPreprocessor() {
+        return this->preprocessor;
+    }
+
+
+    shared_ptr<ShaderProgram> program(const string &vertexPath, const string &fragmentPath, const ShaderPreprocessor::Defines &defines = ShaderPreprocessor::Defines(), bool deferred = false);
+
+    void clear();
+};
+
+
+#endif //__CACHE_H_INCLUDE__
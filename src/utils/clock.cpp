@@ -47,6 +47,10 @@ f64 Clock::elapsed(i64u lastTick) {
     return (f64)(Clock::tick() - lastTick) / Clock::frequencyScale;
 }
 
+f64 Clock::elapsed(i64u fromTick, i64u toTick) {
+    return (f64)(toTick - fromTick) / Clock::frequencyScale;
+}
+
 void Clock::sleep(f64 dt) {
     struct timespec ts;
     f64 seconds;
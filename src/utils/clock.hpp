@@ -36,6 +36,8 @@ public:
 
     static f64 elapsed(i64u lastTick);
 
+    static f64 elapsed(i64u fromTick, i64u toTick);
+
     static void sleep(f64 dt);
 };
 
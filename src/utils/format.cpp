@@ -0,0 +1,208 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+// rounds to nearest even, out of range values become infinities
+i16u Half::fromFloat(f32 value) {
+    i32u x;
+
+    memcpy(&x, &value, sizeof(x));
+
+    i32u sign = (x >> 16) & 0x8000;
+    i32 exponent = ((x >> 23) & 0xff) - 127 + 15;
+    i32u mantissa = x & 0x7fffff;
+    i32u half, rest, halfway;
+
+    if (((x >> 23) & 0xff) == 0xff) {
+        return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+    }
+    if (exponent >= 31) {
+        return sign | 0x7c00;
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return sign;
+        }
+
+        i32u shift = 14 - exponent;
+
+        mantissa |= 0x800000;
+        half = mantissa >> shift;
+        rest = mantissa & ((1 << shift) - 1);
+        halfway = 1 << (shift - 1);
+    } else {
+        half = (exponent << 10) | (mantissa >> 13);
+        rest = mantissa & 0x1fff;
+        halfway = 0x1000;
+    }
+    if (rest > halfway || (rest == halfway && (half & 1) != 0)) {
+        half++;
+    }
+    return sign | half;
+}
+
+f32 Half::toFloat(i16u bits) {
+    i32u sign = (bits & 0x8000) << 16;
+    i32u exponent = (bits >> 10) & 0x1f;
+    i32u mantissa = bits & 0x3ff;
+    i32u x;
+    f32 value;
+
+    if (exponent == 0) {
+        value = ldexpf(mantissa, -24);
+        return sign != 0 ? -value : value;
+    }
+    if (exponent == 31) {
+        x = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    memcpy(&value, &x, sizeof(value));
+    return value;
+}
+
+
+static i32u packSigned(f32 value, i32 scale, i32u mask) {
+    value = _max(-1.0f, _min(1.0f, value));
+    return static_cast<i32u>(static_cast<i32>(roundf(value * scale))) & mask;
+}
+
+static f32 unpackSigned(i32 value, i32 scale) {
+    return _max(-1.0f, static_cast<f32>(value) / scale);
+}
+
+Packed2101010::Packed2101010(const Vector<f32, 4> &vec) {
+    this->bits =
+        packSigned(vec[0], 511, 0x3ff) |
+        (packSigned(vec[1], 511, 0x3ff) << 10) |
+        (packSigned(vec[2], 511, 0x3ff) << 20) |
+        (packSigned(vec[3], 1, 0x3) << 30);
+}
+
+Packed2101010::Packed2101010(const Vector<f32, 3> &vec) : Packed2101010(Vector<f32, 4>(vec)) {
+}
+
+Vector<f32, 4> Packed2101010::unpack() const {
+    f32 data[4] = {
+        unpackSigned(static_cast<i32>(this->bits << 22) >> 22, 511),
+        unpackSigned(static_cast<i32>(this->bits << 12) >> 22, 511),
+        unpackSigned(static_cast<i32>(this->bits << 2) >> 22, 511),
+        unpackSigned(static_cast<i32>(this->bits) >> 30, 1)
+    };
+
+    return Vector<f32, 4>(data);
+}
+
+
+static bool isGLIntegerType(GLenum type) {
+    switch (type) {
+        case GL_BOOL:
+        case GL_BOOL_VEC2:
+        case GL_BOOL_VEC3:
+        case GL_BOOL_VEC4:
+        case GL_INT:
+        case GL_INT_VEC2:
+        case GL_INT_VEC3:
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC4:
+            return true;
+    }
+    return false;
+}
+
+void setupVertexAttributes(
+    GLuint vertexArray,
+    const Buffer &buffer,
+    i32u vertexCount,
+    i32u stride,
+    const VertexAttributeInfo *attributes,
+    i32u count,
+    VertexLayout layout,
+    const ShaderProgram &program,
+    GLuint binding,
+    GLuint divisor
+) {
+    bool dsa = GLState::directStateAccess();
+
+    if (vertexArray == GL_ZERO) {
+        return;
+    }
+    if (dsa && layout == VERTEX_INTERLEAVED) {
+        glVertexArrayVertexBuffer(vertexArray, binding, buffer.handle(), 0, stride);
+        glVertexArrayBindingDivisor(vertexArray, binding, divisor);
+    }
+    if (!dsa) {
+        GLState::bindVertexArray(vertexArray);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, buffer.handle());
+    }
+
+    for (i32u i = 0; i < count; i++) {
+        const VertexAttributeInfo &attribute(attributes[i]);
+        const ShaderProgram::Attribute &input(program.attribute(attribute.name));
+        bool integer = isGLIntegerType(input.type) && attribute.type != GL_FLOAT && attribute.type != GL_HALF_FLOAT;
+        GLuint attributeBinding = binding;
+        i32u attributeStride = stride;
+        i32u offset = attribute.offset;
+
+        if (input.location < 0) {
+            continue;
+        }
+        if (layout == VERTEX_SEPARATE) {
+            attributeBinding = binding + i;
+            attributeStride = (attribute.size + 3) / 4 * 4;
+            offset = attribute.offset * vertexCount;
+        }
+
+        if (dsa) {
+            if (layout == VERTEX_SEPARATE) {
+                glVertexArrayVertexBuffer(vertexArray, attributeBinding, buffer.handle(), offset, attributeStride);
+                glVertexArrayBindingDivisor(vertexArray, attributeBinding, divisor);
+                offset = 0;
+            }
+            if (integer) {
+                glVertexArrayAttribIFormat(vertexArray, input.location, attribute.components, attribute.type, offset);
+            } else {
+                glVertexArrayAttribFormat(vertexArray, input.location, attribute.components, attribute.type, attribute.normalized, offset);
+            }
+            glVertexArrayAttribBinding(vertexArray, input.location, attributeBinding);
+            glEnableVertexArrayAttrib(vertexArray, input.location);
+            continue;
+        }
+
+        if (integer) {
+            glVertexAttribIPointer(input.location, attribute.components, attribute.type, attributeStride, reinterpret_cast<GLvoid*>((GLintptr)offset));
+        } else {
+            glVertexAttribPointer(input.location, attribute.components, attribute.type, attribute.normalized, attributeStride, reinterpret_cast<GLvoid*>((GLintptr)offset));
+        }
+        glVertexAttribDivisor(input.location, divisor);
+        glEnableVertexAttribArray(input.location);
+    }
+
+    if (!dsa) {
+        GLState::bindVertexArray(GL_ZERO);
+    }
+}
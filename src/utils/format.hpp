@@ -0,0 +1,324 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __FORMAT_H_INCLUDE__
+#define __FORMAT_H_INCLUDE__
+
+
+// IEEE half precision float, only used as a storage type
+class Half {
+protected:
+    i16u bits;
+
+
+public:
+    inline Half() : bits(0) {
+    }
+
+    inline Half(f32 value) : bits(Half::fromFloat(value)) {
+    }
+
+
+    inline operator f32() const {
+        return Half::toFloat(this->bits);
+    }
+
+
+    static i16u fromFloat(f32 value);
+    static f32 toFloat(i16u bits);
+};
+
+template<int n>
+Vector<Half, n> half(const Vector<f32, n> &vec) {
+    Vector<Half, n> dst;
+
+    for (int i = n - 1; i >= 0; i--) {
+        dst[i] = Half(vec[i]);
+    }
+    return dst;
+}
+
+
+// signed normalized x, y, z in 10 bits each and w in 2 bits, w being the
+// most significant (GL_INT_2_10_10_10_REV)
+class Packed2101010 {
+protected:
+    i32u bits;
+
+
+public:
+    inline Packed2101010() : bits(0) {
+    }
+
+    Packed2101010(const Vector<f32, 4> &vec);
+    Packed2101010(const Vector<f32, 3> &vec);
+
+
+    Vector<f32, 4> unpack() const;
+};
+
+
+template<typename CT>
+struct GLVertexType;
+
+template<GLenum T, bool P = false>
+struct GLVertexTypeOf {
+    static const GLenum type = T;
+    static const bool packed = P;
+};
+
+template<> struct GLVertexType<i8> : GLVertexTypeOf<GL_BYTE> {};
+template<> struct GLVertexType<i8u> : GLVertexTypeOf<GL_UNSIGNED_BYTE> {};
+template<> struct GLVertexType<i16> : GLVertexTypeOf<GL_SHORT> {};
+template<> struct GLVertexType<i16u> : GLVertexTypeOf<GL_UNSIGNED_SHORT> {};
+template<> struct GLVertexType<i32> : GLVertexTypeOf<GL_INT> {};
+template<> struct GLVertexType<i32u> : GLVertexTypeOf<GL_UNSIGNED_INT> {};
+template<> struct GLVertexType<Half> : GLVertexTypeOf<GL_HALF_FLOAT> {};
+template<> struct GLVertexType<f32> : GLVertexTypeOf<GL_FLOAT> {};
+template<> struct GLVertexType<Packed2101010> : GLVertexTypeOf<GL_INT_2_10_10_10_REV, true> {};
+
+
+// shader input names the attributes are matched against
+struct PositionAttribute {
+    static inline const char * name() {
+        return "inPosition";
+    }
+};
+
+struct NormalAttribute {
+    static inline const char * name() {
+        return "inNormal";
+    }
+};
+
+struct ColorAttribute {
+    static inline const char * name() {
+        return "inColor";
+    }
+};
+
+struct TexCoordAttribute {
+    static inline const char * name() {
+        return "inTexCoord";
+    }
+};
+
+
+// packed types hold all their components in one value
+template<typename Name, typename CT, int components, bool normalized = false>
+struct VertexAttribute {
+    typedef Name N;
+    typedef typename conditional<GLVertexType<CT>::packed, CT, Vector<CT, components> >::type V;
+
+    static const GLenum type = GLVertexType<CT>::type;
+    static const GLint count = components;
+    static const bool normalize = normalized;
+    static const i32u size = GLVertexType<CT>::packed ? sizeof(CT) : sizeof(CT) * components;
+
+    static_assert(sizeof(V) == size, "attribute value must be tightly packed");
+};
+
+
+typedef struct {
+    const char *name;
+    GLint components;
+    GLenum type;
+    bool normalized;
+    i32u offset;
+    i32u size;
+} VertexAttributeInfo;
+
+enum VertexLayout {
+    VERTEX_INTERLEAVED,
+    VERTEX_SEPARATE
+};
+
+
+// every attribute starts on a 4 byte boundary, interleaved vertices are
+// stride() bytes apart while separate attributes are packed one after the
+// other, each in its own array
+template<typename First, typename... Rest>
+class VertexFormat {
+public:
+    template<int i>
+    struct At {
+        typedef typename tuple_element<i, tuple<First, Rest...> >::type type;
+    };
+
+
+    static constexpr i32u count = 1 + sizeof...(Rest);
+    static constexpr i32u sizes[] = { First::size, Rest::size... };
+
+
+    static constexpr i32u alignedSize(i32u i) {
+        return (sizes[i] + 3) / 4 * 4;
+    }
+
+    static constexpr i32u offset(i32u i) {
+        return i == 0 ? 0 : offset(i - 1) + alignedSize(i - 1);
+    }
+
+    static constexpr i32u stride() {
+        return offset(count);
+    }
+
+    static const VertexAttributeInfo * attributes() {
+        static VertexAttributeInfo info[1 + sizeof...(Rest)];
+        static const VertexAttributeInfo *described = VertexFormat::describe<0>(info);
+
+        return described;
+    }
+
+
+protected:
+    template<i32u i>
+    static typename enable_if<(i < 1 + sizeof...(Rest)), VertexAttributeInfo *>::type describe(VertexAttributeInfo *info) {
+        typedef typename At<i>::type A;
+
+        info[i] = { A::N::name(), A::count, A::type, A::normalize, offset(i), A::size };
+        return VertexFormat::describe<i + 1>(info);
+    }
+
+    template<i32u i>
+    static typename enable_if<(i == 1 + sizeof...(Rest)), VertexAttributeInfo *>::type describe(VertexAttributeInfo *info) {
+        return info;
+    }
+};
+
+template<typename First, typename... Rest>
+constexpr i32u VertexFormat<First, Rest...>::count;
+
+template<typename First, typename... Rest>
+constexpr i32u VertexFormat<First, Rest...>::sizes[];
+
+
+// points every attribute the program declares at its slice of the buffer,
+// integer inputs are fed without conversion, the others are left alone
+void setupVertexAttributes(
+    GLuint vertexArray,
+    const Buffer &buffer,
+    i32u vertexCount,
+    i32u stride,
+    const VertexAttributeInfo *attributes,
+    i32u count,
+    VertexLayout layout,
+    const ShaderProgram &program,
+    GLuint binding = 0,
+    GLuint divisor = 0
+);
+
+
+template<typename Format, VertexLayout layout = VERTEX_INTERLEAVED>
+class VertexBuffer : public VertexAttributeBuffer {
+protected:
+    template<int i>
+    inline void setFrom(i32u vertex) {
+    }
+
+    template<int i, typename V, typename... Values>
+    inline void setFrom(i32u vertex, const V &value, const Values &... values) {
+        this->template set<i>(vertex, value);
+        this->template setFrom<i + 1>(vertex, values...);
+    }
+
+
+public:
+    VertexBuffer(i32u vertexCount, GLenum usage = GL_STATIC_DRAW) : VertexAttributeBuffer(vertexCount, Format::stride(), usage) {
+    }
+
+    VertexBuffer(const VertexBuffer &buffer) : VertexAttributeBuffer(buffer) {
+    }
+
+    virtual ~VertexBuffer() {
+    }
+
+
+    inline i32u attributeOffset(i32u i) const {
+        return layout == VERTEX_INTERLEAVED ? Format::offset(i) : Format::offset(i) * this->vertexCount;
+    }
+
+    static constexpr i32u attributeStride(i32u i) {
+        return layout == VERTEX_INTERLEAVED ? Format::stride() : Format::alignedSize(i);
+    }
+
+
+    template<int i>
+    void set(i32u vertex, const typename Format::template At<i>::type::V &value) {
+        this->write(this->attributeOffset(i) + vertex * attributeStride(i), Format::template At<i>::type::size, &value);
+    }
+
+    // one write when the attribute array is contiguous
+    template<int i>
+    void set(i32u first, const vector<typename Format::template At<i>::type::V> &values) {
+        typedef typename Format::template At<i>::type A;
+
+        if (attributeStride(i) == A::size) {
+            this->write(this->attributeOffset(i) + first * A::size, values.size() * A::size, values.data());
+            return;
+        }
+        for (i32u j = 0; j < values.size(); j++) {
+            this->template set<i>(first + j, values[j]);
+        }
+    }
+
+    template<typename... Values>
+    void setVertex(i32u vertex, const Values &... values) {
+        static_assert(sizeof...(Values) == Format::count, "one value per attribute");
+
+        this->template setFrom<0>(vertex, values...);
+    }
+
+
+    // separate layouts take one binding per attribute, starting at binding
+    inline void setup(GLuint vertexArray, const ShaderProgram &program, GLuint binding = 0, GLuint divisor = 0) const {
+        setupVertexAttributes(vertexArray, *this, this->vertexCount, Format::stride(), Format::attributes(), Format::count, layout, program, binding, divisor);
+    }
+};
+
+
+template<typename VT, int vertexCoords>
+using VertexAttributeBufferV = VertexBuffer<VertexFormat<
+    VertexAttribute<PositionAttribute, VT, vertexCoords>
+> >;
+
+template<typename VT, int vertexCoords, typename NT, int normalCoords>
+using VertexAttributeBufferVN = VertexBuffer<VertexFormat<
+    VertexAttribute<PositionAttribute, VT, vertexCoords>,
+    VertexAttribute<NormalAttribute, NT, normalCoords>
+> >;
+
+template<typename VT, int vertexCoords, typename NT, int normalCoords, typename CT, int colorCoords>
+using VertexAttributeBufferVNC = VertexBuffer<VertexFormat<
+    VertexAttribute<PositionAttribute, VT, vertexCoords>,
+    VertexAttribute<NormalAttribute, NT, normalCoords>,
+    VertexAttribute<ColorAttribute, CT, colorCoords>
+> >;
+
+template<typename VT, int vertexCoords, typename NT, int normalCoords, typename TT, int textureCoords>
+using VertexAttributeBufferVNT = VertexBuffer<VertexFormat<
+    VertexAttribute<PositionAttribute, VT, vertexCoords>,
+    VertexAttribute<NormalAttribute, NT, normalCoords>,
+    VertexAttribute<TexCoordAttribute, TT, textureCoords>
+> >;
+
+
+#endif //__FORMAT_H_INCLUDE__
@@ -0,0 +1,185 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+thread_local i32 JobSystem::current = -1;
+
+
+JobSystem::JobSystem(i32u workers) : queued(0), stopping(false) {
+    for (i32u i = 0; i <= workers; i++) {
+        this->queues.emplace_back(new Queue());
+    }
+    for (i32u i = 0; i < workers; i++) {
+        this->threads.emplace_back(&JobSystem::work, this, i);
+    }
+}
+
+// pending jobs are still run before the workers leave
+JobSystem::~JobSystem() {
+    {
+        lock_guard<mutex> guard(this->sleepLock);
+
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (auto it = this->threads.begin(); it != this->threads.end(); it++) {
+        (*it).join();
+    }
+}
+
+
+i32u JobSystem::self() const {
+    if (JobSystem::current >= 0 && (i32u)JobSystem::current < this->threads.size()) {
+        return JobSystem::current;
+    }
+    return this->threads.size();
+}
+
+bool JobSystem::pop(i32u queue, bool newest, Entry &entry) {
+    Queue &q(*this->queues[queue]);
+    lock_guard<mutex> guard(q.lock);
+
+    if (q.entries.empty()) {
+        return false;
+    }
+    if (newest) {
+        entry = q.entries.back();
+        q.entries.pop_back();
+    } else {
+        entry = q.entries.front();
+        q.entries.pop_front();
+    }
+    this->queued--;
+    return true;
+}
+
+// own queue first, then steal from the next queues in turn
+bool JobSystem::runOne(i32u queue) {
+    Entry entry;
+    bool found = this->pop(queue, true, entry);
+
+    for (i32u i = 1; !found && i < this->queues.size(); i++) {
+        found = this->pop((queue + i) % this->queues.size(), false, entry);
+    }
+    if (!found) {
+        return false;
+    }
+    entry.job();
+    entry.group->pending--;
+    return true;
+}
+
+void JobSystem::work(i32u queue) {
+    JobSystem::current = queue;
+    while (true) {
+        if (this->runOne(queue)) {
+            continue;
+        }
+
+        unique_lock<mutex> guard(this->sleepLock);
+
+        this->wake.wait(guard, [this] () {
+            return this->stopping || this->queued.load() > 0;
+        });
+        if (this->stopping && this->queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+
+// the sleep lock is taken after queueing so a worker cannot miss the job
+// between checking for work and going to sleep
+void JobSystem::submit(Group &group, const Job &job) {
+    Entry entry = { job, &group };
+
+    if (this->threads.empty()) {
+        job();
+        return;
+    }
+
+    Queue &q(*this->queues[this->self()]);
+
+    group.pending++;
+    {
+        lock_guard<mutex> guard(q.lock);
+
+        q.entries.push_back(entry);
+    }
+    this->queued++;
+    {
+        lock_guard<mutex> guard(this->sleepLock);
+    }
+    this->wake.notify_one();
+}
+
+void JobSystem::wait(Group &group) {
+    i32u queue = this->self();
+
+    while (!group.isDone()) {
+        if (!this->runOne(queue)) {
+            this_thread::yield();
+        }
+    }
+}
+
+// the range is cut in chunks of grain items, by default about four per
+// thread; the calling thread takes part
+void JobSystem::parallelFor(i32u count, const RangeJob &job, i32u grain) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = _max((i32u)1, count / (4 * ((i32u)this->threads.size() + 1)));
+    }
+    if (this->threads.empty() || count <= grain) {
+        job(0, count);
+        return;
+    }
+
+    Group group;
+
+    for (i32u begin = 0; begin < count; begin += grain) {
+        i32u end = _min(count, begin + grain);
+
+        this->submit(group, [&job, begin, end] () {
+            job(begin, end);
+        });
+    }
+    this->wait(group);
+}
+
+
+// one thread per core, the calling thread being one of them
+i32u JobSystem::defaultWorkers() {
+    i32u cores = thread::hardware_concurrency();
+
+    return cores > 1 ? cores - 1 : 0;
+}
+
+JobSystem & JobSystem::shared() {
+    static JobSystem jobs;
+
+    return jobs;
+}
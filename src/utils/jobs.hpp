@@ -0,0 +1,105 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __JOBS_H_INCLUDE__
+#define __JOBS_H_INCLUDE__
+
+
+// fixed pool of worker threads, each with its own job deque: a worker
+// takes its newest job first and, once dry, steals the oldest job of the
+// others; threads waiting on a group run jobs instead of blocking
+class JobSystem {
+public:
+    typedef function<void ()> Job;
+    typedef function<void (i32u begin, i32u end)> RangeJob;
+
+
+    // jobs submitted together, waited for together
+    class Group {
+    protected:
+        friend class JobSystem;
+
+        atomic<i32u> pending;
+
+
+    public:
+        inline Group() : pending(0) {
+        }
+
+        inline bool isDone() const {
+            return this->pending.load() == 0;
+        }
+    };
+
+
+protected:
+    typedef struct {
+        Job job;
+        Group *group;
+    } Entry;
+
+    typedef struct {
+        mutex lock;
+        deque<Entry> entries;
+    } Queue;
+
+
+    // queue of the calling thread, the last queue is shared by the
+    // threads that are not workers
+    static thread_local i32 current;
+
+
+    vector<unique_ptr<Queue> > queues;
+    vector<thread> threads;
+    mutex sleepLock;
+    condition_variable wake;
+    atomic<i32u> queued;
+    bool stopping;
+
+
+    i32u self() const;
+    bool pop(i32u queue, bool newest, Entry &entry);
+    bool runOne(i32u queue);
+    void work(i32u queue);
+
+
+public:
+    JobSystem(i32u workers = JobSystem::defaultWorkers());
+    ~JobSystem();
+
+
+    void submit(Group &group, const Job &job);
+    void wait(Group &group);
+
+    void parallelFor(i32u count, const RangeJob &job, i32u grain = 0);
+
+    inline i32u getWorkerCount() const {
+        return this->threads.size();
+    }
+
+
+    static i32u defaultWorkers();
+    static JobSystem & shared();
+};
+
+
+#endif //__JOBS_H_INCLUDE__
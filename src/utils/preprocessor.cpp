@@ -0,0 +1,181 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+static string directoryOf(const string &path) {
+    size_t slash = path.find_last_of('/');
+
+    if (slash == string::npos) {
+        return "";
+    }
+    return path.substr(0, slash + 1);
+}
+
+static bool fileExists(const string &path) {
+    struct stat info;
+
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+// returns the directive keyword of a preprocessor line, empty otherwise
+static string directiveOf(const string &line, size_t &end) {
+    size_t i = line.find_first_not_of(" \t");
+
+    if (i == string::npos || line[i] != '#') {
+        return "";
+    }
+    i = line.find_first_not_of(" \t", i + 1);
+    if (i == string::npos) {
+        return "";
+    }
+    end = line.find_first_of(" \t", i);
+    if (end == string::npos) {
+        end = line.length();
+    }
+    return line.substr(i, end - i);
+}
+
+// number a #line directive gives the line following it: before GLSL 330 it
+// names that line's predecessor, a missing #version stands for 110
+static i32u lineBaseOf(const string &version) {
+    size_t i = version.find("version");
+    i32 number = 110;
+
+    if (i != string::npos) {
+        number = strtol(version.c_str() + i + 7, NULL, 10);
+    }
+    return number >= 330 ? 1 : 0;
+}
+
+
+ShaderPreprocessor::ShaderPreprocessor() {
+}
+
+void ShaderPreprocessor::addIncludePath(const string &path) {
+    if (path.length() > 0 && path[path.length() - 1] != '/') {
+        this->includePaths.push_back(path + "/");
+    } else {
+        this->includePaths.push_back(path);
+    }
+}
+
+string ShaderPreprocessor::resolve(const string &name, const string &from) const {
+    if (name.length() > 0 && name[0] == '/') {
+        return fileExists(name) ? name : "";
+    }
+    if (fileExists(directoryOf(from) + name)) {
+        return directoryOf(from) + name;
+    }
+    for (auto it = this->includePaths.begin(); it != this->includePaths.end(); it++) {
+        if (fileExists((*it) + name)) {
+            return (*it) + name;
+        }
+    }
+    return "";
+}
+
+bool ShaderPreprocessor::expand(const string &path, const string &source, set<string> &included, i32u &files, stringstream &output, string &version) const {
+    istringstream input(source);
+    i32u file = files++;
+    i32u lineNumber = 0;
+    string line;
+
+    included.insert(path);
+    while (getline(input, line)) {
+        size_t end = 0;
+        string directive(directiveOf(line, end));
+
+        lineNumber++;
+        if (directive == "version") {
+            // only the main file may declare the version, it is emitted first
+            if (file == 0 && version.length() == 0) {
+                version = line;
+            }
+            output << "\n";
+        } else if (directive == "include") {
+            size_t open = line.find('"', end);
+            size_t close = (open != string::npos ? line.find('"', open + 1) : string::npos);
+            string name;
+            string resolved;
+
+            if (close == string::npos) {
+                fprintf(stderr, "ERROR: Malformed include in %s:%u!\n", path.c_str(), lineNumber);
+                return false;
+            }
+            name = line.substr(open + 1, close - open - 1);
+            resolved = this->resolve(name, path);
+            if (resolved.length() == 0) {
+                fprintf(stderr, "ERROR: Cannot include %s from %s:%u!\n", name.c_str(), path.c_str(), lineNumber);
+                return false;
+            }
+            if (included.count(resolved) == 0) {
+                output << "#line " << lineBaseOf(version) << " " << files << "\n";
+                if (!this->expand(resolved, Shader::readFile(resolved), included, files, output, version)) {
+                    return false;
+                }
+                output << "#line " << (lineNumber + lineBaseOf(version)) << " " << file << "\n";
+            } else {
+                output << "\n";
+            }
+        } else {
+            output << line << "\n";
+        }
+    }
+    return true;
+}
+
+bool ShaderPreprocessor::process(const string &path, const Defines &defines, string &output) const {
+    if (!fileExists(path)) {
+        fprintf(stderr, "ERROR: Cannot read shader %s!\n", path.c_str());
+        return false;
+    }
+    return this->processSource(path, Shader::readFile(path), defines, output);
+}
+
+bool ShaderPreprocessor::processSource(const string &path, const string &source, const Defines &defines, string &output) const {
+    set<string> included;
+    stringstream body;
+    stringstream header;
+    string version;
+    i32u files = 0;
+
+    if (!this->expand(path, source, included, files, body, version)) {
+        return false;
+    }
+
+    if (version.length() > 0) {
+        header << version << "\n";
+    }
+    for (auto it = defines.begin(); it != defines.end(); it++) {
+        header << "#define " << (*it).first;
+        if ((*it).second.length() > 0) {
+            header << " " << (*it).second;
+        }
+        header << "\n";
+    }
+    header << "#line " << lineBaseOf(version) << " 0\n";
+
+    output = header.str() + body.str();
+    return true;
+}
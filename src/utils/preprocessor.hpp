@@ -0,0 +1,55 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __PREPROCESSOR_H_INCLUDE__
+#define __PREPROCESSOR_H_INCLUDE__
+
+
+// expands #include "file" directives and injects defines right after the
+// #version line, #line directives keep compiler messages pointing at the
+// original files (source string 0 is the main file, includes are numbered
+// in order of appearance)
+class ShaderPreprocessor {
+public:
+    typedef map<string, string> Defines;
+
+
+protected:
+    list<string> includePaths;
+
+
+    string resolve(const string &name, const string &from) const;
+    bool expand(const string &path, const string &source, set<string> &included, i32u &files, stringstream &output, string &version) const;
+
+
+public:
+    ShaderPreprocessor();
+
+
+    void addIncludePath(const string &path);
+
+    bool process(const string &path, const Defines &defines, string &output) const;
+    bool processSource(const string &path, const string &source, const Defines &defines, string &output) const;
+};
+
+
+#endif //__PREPROCESSOR_H_INCLUDE__
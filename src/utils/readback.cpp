@@ -0,0 +1,260 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+// staging buffers kept around for the next requests
+static const i32u stagingPoolSize = 8;
+
+
+Readback::Result::Result(Readback *readback, i64u serial, const shared_future<vector<i8u> > &delivered) : readback(readback), serial(serial), owner(this_thread::get_id()), delivered(delivered) {
+}
+
+bool Readback::Result::isReady() const {
+    return this->delivered.wait_for(chrono::seconds(0)) == future_status::ready;
+}
+
+// a destroyed readback breaks the promise, so it is only reached while alive
+const vector<i8u> & Readback::Result::get() const {
+    if (!this->isReady() && this_thread::get_id() == this->owner) {
+        this->readback->finish(this->serial);
+    }
+    return this->delivered.get();
+}
+
+
+Readback::Readback() : submitted(0) {
+}
+
+Readback::~Readback() {
+    for (auto it = this->requests.begin(); it != this->requests.end(); it++) {
+        glDeleteSync((*it).fence);
+    }
+}
+
+
+shared_ptr<Buffer> Readback::acquire(i32u size) {
+    auto best = this->pool.end();
+
+    for (auto it = this->pool.begin(); it != this->pool.end(); it++) {
+        if ((*it)->size >= size && (best == this->pool.end() || (*it)->size < (*best)->size)) {
+            best = it;
+        }
+    }
+    if (best != this->pool.end()) {
+        shared_ptr<Buffer> staging(*best);
+
+        this->pool.erase(best);
+        return staging;
+    }
+    return shared_ptr<Buffer>(new Buffer(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ));
+}
+
+void Readback::submit(const shared_ptr<Buffer> &staging, i32u size, const Callback &callback) {
+    Request request = {
+        staging,
+        size,
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+        callback,
+        ++this->submitted
+    };
+
+    // make sure the fence reaches the GPU even if nothing else is submitted
+    glFlush();
+    this->requests.push_back(request);
+}
+
+// the copy has landed, reading the staging buffer no longer stalls
+void Readback::deliver(Request &request) {
+    this->data.resize(request.size);
+    request.staging->getData(0, request.size, this->data.data());
+    glDeleteSync(request.fence);
+    request.fence = NULL;
+
+    if (this->pool.size() < stagingPoolSize) {
+        this->pool.push_back(request.staging);
+    }
+    if (request.callback) {
+        request.callback(this->data.data(), request.size);
+    }
+}
+
+void Readback::readBuffer(const Buffer &buffer, i32u offset, i32u size, const Callback &callback) {
+    shared_ptr<Buffer> staging(this->acquire(size));
+
+    if (GLState::directStateAccess()) {
+        glCopyNamedBufferSubData(buffer.handle(), staging->handle(), offset, 0, size);
+    } else {
+        GLState::bindBuffer(GL_COPY_READ_BUFFER, buffer.handle());
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, staging->handle());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, size);
+        GLState::unbindBuffer(GL_COPY_WRITE_BUFFER);
+        GLState::unbindBuffer(GL_COPY_READ_BUFFER);
+    }
+    this->submit(staging, size, callback);
+}
+
+// rows are tightly packed in the delivered data
+void Readback::readPixels(i32 x, i32 y, i32 width, i32 height, GLenum format, GLenum type, const Callback &callback) {
+    i32u size = width * height * Readback::getGLPixelSize(format, type);
+    GLint alignment = 4;
+
+    if (size == 0) {
+        fprintf(stderr, "ERROR: Unsupported readback pixel format (%d, %d)\n", format, type);
+        return;
+    }
+
+    shared_ptr<Buffer> staging(this->acquire(size));
+
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, staging->handle());
+    glReadPixels(x, y, width, height, format, type, reinterpret_cast<GLvoid*>(0));
+    GLState::unbindBuffer(GL_PIXEL_PACK_BUFFER);
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+
+    this->submit(staging, size, callback);
+}
+
+Readback::Result Readback::readBuffer(const Buffer &buffer, i32u offset, i32u size) {
+    shared_ptr<promise<vector<i8u> > > result(new promise<vector<i8u> >());
+
+    this->readBuffer(buffer, offset, size, [result] (const GLvoid *data, i32u size) {
+        const i8u *bytes = reinterpret_cast<const i8u *>(data);
+
+        result->set_value(vector<i8u>(bytes, bytes + size));
+    });
+    return Result(this, this->submitted, result->get_future().share());
+}
+
+Readback::Result Readback::readPixels(i32 x, i32 y, i32 width, i32 height, GLenum format, GLenum type) {
+    shared_ptr<promise<vector<i8u> > > result(new promise<vector<i8u> >());
+
+    this->readPixels(x, y, width, height, format, type, [result] (const GLvoid *data, i32u size) {
+        const i8u *bytes = reinterpret_cast<const i8u *>(data);
+
+        result->set_value(vector<i8u>(bytes, bytes + size));
+    });
+    return Result(this, this->submitted, result->get_future().share());
+}
+
+
+// delivers the requests whose fence has passed, in submission order
+i32u Readback::poll() {
+    i32u delivered = 0;
+
+    while (!this->requests.empty()) {
+        Request &request(this->requests.front());
+        GLenum status = glClientWaitSync(request.fence, 0, 0);
+
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        this->deliver(request);
+        this->requests.pop_front();
+        delivered++;
+    }
+    return delivered;
+}
+
+void Readback::finish() {
+    this->finish(this->submitted);
+}
+
+// waits for the requests submitted up to serial, the later ones stay queued
+void Readback::finish(i64u serial) {
+    while (!this->requests.empty() && this->requests.front().serial <= serial) {
+        Request &request(this->requests.front());
+
+        while (glClientWaitSync(request.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        this->deliver(request);
+        this->requests.pop_front();
+    }
+}
+
+
+i32u Readback::getGLPixelSize(GLenum format, GLenum type) {
+    i32u components = 0;
+    i32u size = 0;
+
+    switch (type) {
+        case GL_UNSIGNED_INT_8_8_8_8:
+        case GL_UNSIGNED_INT_8_8_8_8_REV:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_24_8:
+            return 4;
+
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:
+            size = 1;
+            break;
+
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT:
+            size = 2;
+            break;
+
+        case GL_UNSIGNED_INT:
+        case GL_INT:
+        case GL_FLOAT:
+            size = 4;
+            break;
+
+        default:
+            return 0;
+    }
+
+    switch (format) {
+        case GL_RED:
+        case GL_GREEN:
+        case GL_BLUE:
+        case GL_RED_INTEGER:
+        case GL_DEPTH_COMPONENT:
+        case GL_STENCIL_INDEX:
+            components = 1;
+            break;
+
+        case GL_RG:
+        case GL_RG_INTEGER:
+            components = 2;
+            break;
+
+        case GL_RGB:
+        case GL_BGR:
+        case GL_RGB_INTEGER:
+            components = 3;
+            break;
+
+        case GL_RGBA:
+        case GL_BGRA:
+        case GL_RGBA_INTEGER:
+            components = 4;
+            break;
+
+        default:
+            return 0;
+    }
+    return components * size;
+}
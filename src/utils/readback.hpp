@@ -0,0 +1,106 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __READBACK_H_INCLUDE__
+#define __READBACK_H_INCLUDE__
+
+
+// asynchronous copies from buffers and the framebuffer: the GPU copies
+// into a staging buffer, a fence follows, and poll() hands the data to
+// the callback once the fence has passed, without ever waiting on it
+class Readback {
+public:
+    typedef function<void (const GLvoid *data, i32u size)> Callback;
+
+
+    // filled by poll() between frames on the GL thread: isReady() never
+    // blocks, get() on the GL thread finishes the requests up to this one
+    // rather than waiting for a poll() that cannot come, get() on another
+    // thread waits for it
+    class Result {
+    protected:
+        Readback *readback;
+        i64u serial;
+        thread::id owner;
+        shared_future<vector<i8u> > delivered;
+
+
+    public:
+        Result(Readback *readback, i64u serial, const shared_future<vector<i8u> > &delivered);
+
+
+        bool isReady() const;
+        const vector<i8u> & get() const;
+    };
+
+
+protected:
+    typedef struct {
+        shared_ptr<Buffer> staging;
+        i32u size;
+        GLsync fence;
+        Callback callback;
+        i64u serial;
+    } Request;
+
+
+    list<Request> requests;
+    list<shared_ptr<Buffer> > pool;
+    vector<i8u> data;
+    i64u submitted;
+
+
+    shared_ptr<Buffer> acquire(i32u size);
+    void submit(const shared_ptr<Buffer> &staging, i32u size, const Callback &callback);
+    void deliver(Request &request);
+
+
+public:
+    Readback();
+    // the fences belong to one readback only
+    Readback(const Readback &readback) = delete;
+    ~Readback();
+
+
+    Readback & operator =(const Readback &readback) = delete;
+
+
+    void readBuffer(const Buffer &buffer, i32u offset, i32u size, const Callback &callback);
+    void readPixels(i32 x, i32 y, i32 width, i32 height, GLenum format, GLenum type, const Callback &callback);
+
+    Result readBuffer(const Buffer &buffer, i32u offset, i32u size);
+    Result readPixels(i32 x, i32 y, i32 width, i32 height, GLenum format, GLenum type);
+
+    i32u poll();
+    void finish();
+    void finish(i64u serial);
+
+    inline i32u pending() const {
+        return this->requests.size();
+    }
+
+
+    static i32u getGLPixelSize(GLenum format, GLenum type);
+};
+
+
+#endif //__READBACK_H_INCLUDE__
@@ -23,6 +23,19 @@
 #include "archifake.hpp"
 
 
+// arrays of vectors and square matrices are uploaded in place, matrices
+// are stored row-major so GL is asked to transpose them on upload
+static_assert(sizeof(Vector<i32, 2>) == 2 * sizeof(i32) && is_trivially_copyable<Vector<i32, 2> >::value, "Vector<i32, 2> must be packed");
+static_assert(sizeof(Vector<i32, 3>) == 3 * sizeof(i32) && is_trivially_copyable<Vector<i32, 3> >::value, "Vector<i32, 3> must be packed");
+static_assert(sizeof(Vector<i32, 4>) == 4 * sizeof(i32) && is_trivially_copyable<Vector<i32, 4> >::value, "Vector<i32, 4> must be packed");
+static_assert(sizeof(Vector<f32, 2>) == 2 * sizeof(f32) && is_trivially_copyable<Vector<f32, 2> >::value, "Vector<f32, 2> must be packed");
+static_assert(sizeof(Vector<f32, 3>) == 3 * sizeof(f32) && is_trivially_copyable<Vector<f32, 3> >::value, "Vector<f32, 3> must be packed");
+static_assert(sizeof(Vector<f32, 4>) == 4 * sizeof(f32) && is_trivially_copyable<Vector<f32, 4> >::value, "Vector<f32, 4> must be packed");
+static_assert(sizeof(Matrix<f32, 2, 2>) == 4 * sizeof(f32) && is_trivially_copyable<Matrix<f32, 2, 2> >::value, "Matrix<f32, 2, 2> must be packed");
+static_assert(sizeof(Matrix<f32, 3, 3>) == 9 * sizeof(f32) && is_trivially_copyable<Matrix<f32, 3, 3> >::value, "Matrix<f32, 3, 3> must be packed");
+static_assert(sizeof(Matrix<f32, 4, 4>) == 16 * sizeof(f32) && is_trivially_copyable<Matrix<f32, 4, 4> >::value, "Matrix<f32, 4, 4> must be packed");
+
+
 static const char * getGLTypeName(GLint type) {
     switch (type) {
     case GL_BOOL:
@@ -218,8 +231,85 @@ static const char * getGLTypeName(GLint type) {
     return "unknown";
 }
 
+bool isGLSamplerType(GLenum type) {
+    switch (type) {
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_3D:
+    case GL_INT_SAMPLER_CUBE:
+    case GL_INT_IMAGE_2D:
+    case GL_INT_IMAGE_2D_ARRAY:
+    case GL_INT_IMAGE_3D:
+    case GL_INT_IMAGE_CUBE:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_3D:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE:
+    case GL_UNSIGNED_INT_IMAGE_2D:
+    case GL_UNSIGNED_INT_IMAGE_2D_ARRAY:
+    case GL_UNSIGNED_INT_IMAGE_3D:
+    case GL_UNSIGNED_INT_IMAGE_CUBE:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_IMAGE_2D:
+    case GL_IMAGE_2D_ARRAY:
+    case GL_IMAGE_3D:
+    case GL_IMAGE_CUBE:
+        return true;
+    }
+    return false;
+}
+
+static i32u getGLTypeSize(GLenum type) {
+    if (isGLSamplerType(type)) {
+        return sizeof(i32);
+    }
+    switch (type) {
+    case GL_BOOL:
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+        return 4;
+    case GL_BOOL_VEC2:
+    case GL_INT_VEC2:
+    case GL_UNSIGNED_INT_VEC2:
+    case GL_FLOAT_VEC2:
+        return 8;
+    case GL_BOOL_VEC3:
+    case GL_INT_VEC3:
+    case GL_UNSIGNED_INT_VEC3:
+    case GL_FLOAT_VEC3:
+        return 12;
+    case GL_BOOL_VEC4:
+    case GL_INT_VEC4:
+    case GL_UNSIGNED_INT_VEC4:
+    case GL_FLOAT_VEC4:
+    case GL_FLOAT_MAT2:
+        return 16;
+    case GL_FLOAT_MAT2x3:
+    case GL_FLOAT_MAT3x2:
+        return 24;
+    case GL_FLOAT_MAT2x4:
+    case GL_FLOAT_MAT4x2:
+        return 32;
+    case GL_FLOAT_MAT3:
+        return 36;
+    case GL_FLOAT_MAT3x4:
+    case GL_FLOAT_MAT4x3:
+        return 48;
+    case GL_FLOAT_MAT4:
+        return 64;
+    }
+    return 0;
+}
+
 
-Shader::Shader(GLenum type, const string &source) : id(GL_ZERO), compiled(false), type(type), source(source) {
+Shader::Shader(GLenum type, const string &source, bool deferred) : id(GL_ZERO), pending(false), compiled(false), type(type), source(source) {
     this->id = glCreateShader(type);
     if (this->id == GL_ZERO) {
         return;
@@ -236,7 +326,28 @@ Shader::Shader(GLenum type, const string &source) : id(GL_ZERO), compiled(false)
         glShaderSource(this->id, 1, sources, lengths);
     }
 
+    if (deferred) {
+        Shader::parallelCompile();
+    }
     glCompileShader(this->id);
+    this->pending = true;
+    if (!deferred) {
+        this->complete();
+    }
+}
+
+Shader::~Shader() {
+    if (this->id != GL_ZERO) {
+        glDeleteShader(this->id);
+    }
+}
+
+void Shader::complete() const {
+    if (!this->pending) {
+        return;
+    }
+    this->pending = false;
+
     {
         GLint status = GL_FALSE;
 
@@ -257,22 +368,45 @@ Shader::Shader(GLenum type, const string &source) : id(GL_ZERO), compiled(false)
     }
 }
 
-Shader::~Shader() {
-    if (this->id != GL_ZERO) {
-        glDeleteShader(this->id);
+// without KHR_parallel_shader_compile the status query is only postponed
+// to the first use, which then blocks
+bool Shader::isReady() const {
+    if (this->pending && Shader::parallelCompile()) {
+        GLint status = GL_FALSE;
+
+        glGetShaderiv(this->id, GL_COMPLETION_STATUS_KHR, &status);
+        if (!status) {
+            return false;
+        }
     }
+    return true;
 }
 
 bool Shader::isCompiled() const {
+    this->complete();
     return this->compiled;
 }
 
 const string & Shader::getLogs() const {
+    this->complete();
     return this->logs;
 }
 
 
-shared_ptr<Shader> Shader::fromFile(GLenum type, const string &path) {
+bool Shader::parallelCompile() {
+    static i32 supported = -1;
+
+    if (supported < 0) {
+        supported = GLEW_KHR_parallel_shader_compile ? 1 : 0;
+        if (supported) {
+            glMaxShaderCompilerThreadsKHR(0xffffffff);
+        }
+    }
+    return supported > 0;
+}
+
+
+string Shader::readFile(const string &path) {
     stringstream source;
     ifstream file(path);
     int c;
@@ -280,12 +414,21 @@ shared_ptr<Shader> Shader::fromFile(GLenum type, const string &path) {
     while ((c = file.get()) != EOF) {
         source.put((char)c);
     }
-    return shared_ptr<Shader>(new Shader(type, source.str()));
+    return source.str();
+}
+
+shared_ptr<Shader> Shader::fromFile(GLenum type, const string &path, bool deferred) {
+    return shared_ptr<Shader>(new Shader(type, Shader::readFile(path), deferred));
 }
 
 
+const GLuint ShaderProgram::frameConstantsBinding;
+const GLuint ShaderProgram::surfaceConstantsBinding;
+const GLuint ShaderProgram::drawTransformsBinding;
+
 const ShaderProgram::UniformBlock ShaderProgram::emptyUniformBlock = {
     "",
+    GL_INVALID_INDEX,
     -1,
     0,
     0
@@ -311,35 +454,55 @@ const ShaderProgram::Attribute ShaderProgram::emptyAttribute = {
 };
 
 
-ShaderProgram::ShaderProgram(const shared_ptr<Shader> &vertexShader, const shared_ptr<Shader> &fragmentShader) : id(GL_ZERO), linked(false), validated(false), enabled(0) {
+ShaderProgram::ShaderProgram() : id(GL_ZERO), pending(false), linked(false), validated(false), enabled(0), shadowing(false), issuedUploads(0), skippedUploads(0) {
+}
+
+ShaderProgram::ShaderProgram(const shared_ptr<Shader> &vertexShader, const shared_ptr<Shader> &fragmentShader, bool deferred) : id(GL_ZERO), pending(false), linked(false), validated(false), enabled(0), shadowing(false), issuedUploads(0), skippedUploads(0) {
     this->shaders.push_back(vertexShader);
     this->shaders.push_back(fragmentShader);
-    this->link();
+    this->link(deferred);
 }
 
-ShaderProgram::ShaderProgram(const list<shared_ptr<Shader> > &shaders) : id(GL_ZERO), linked(false), validated(false), enabled(0), shaders(shaders) {
-    this->link();
+ShaderProgram::ShaderProgram(const list<shared_ptr<Shader> > &shaders, bool deferred) : id(GL_ZERO), pending(false), linked(false), validated(false), enabled(0), shaders(shaders), shadowing(false), issuedUploads(0), skippedUploads(0) {
+    this->link(deferred);
 }
 
 ShaderProgram::~ShaderProgram() {
     if (this->id != GL_ZERO) {
-        glDeleteProgram(this->id);
+        GLState::deleteProgram(this->id);
     }
 }
 
-void ShaderProgram::link() {
+// deferred programs attach their shaders without waiting for the compile
+// status, a failed compile then surfaces as a link error
+void ShaderProgram::link(bool deferred) {
     this->id = glCreateProgram();
     if (this->id == GL_ZERO) {
         return;
     }
 
-    for_each(this->shaders.begin(), this->shaders.end(), [this] (const shared_ptr<Shader> &shader) {
-        if (shader && shader->isCompiled()) {
+    for_each(this->shaders.begin(), this->shaders.end(), [this, deferred] (const shared_ptr<Shader> &shader) {
+        if (shader && shader->id != GL_ZERO && (deferred || shader->isCompiled())) {
             glAttachShader(this->id, shader->id);
         }
     });
 
+    if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+        glProgramParameteri(this->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(this->id);
+    this->pending = true;
+    if (!deferred) {
+        this->complete();
+    }
+}
+
+void ShaderProgram::complete() const {
+    if (!this->pending) {
+        return;
+    }
+    this->pending = false;
+
     {
         GLint status = GL_FALSE;
 
@@ -413,6 +576,7 @@ void ShaderProgram::link() {
 
             this->uniformBlocks[name] = {
                 name,
+                (GLuint)i,
                 location,
                 uniforms,
                 size
@@ -420,21 +584,21 @@ void ShaderProgram::link() {
         }
         count = 0;
         glGetProgramiv(this->id, GL_ACTIVE_UNIFORMS, &count);
-        indices.reserve(count);
+        indices.resize(count);
         for (GLint i = 0; i < count; i++) {
             indices[i] = i;
         }
-        blocks.reserve(count);
+        blocks.resize(count);
         glGetActiveUniformsiv(this->id, count, indices.data(), GL_UNIFORM_BLOCK_INDEX, blocks.data());
-        offsets.reserve(count);
+        offsets.resize(count);
         glGetActiveUniformsiv(this->id, count, indices.data(), GL_UNIFORM_OFFSET, offsets.data());
-        arrayStrides.reserve(count);
+        arrayStrides.resize(count);
         glGetActiveUniformsiv(this->id, count, indices.data(), GL_UNIFORM_ARRAY_STRIDE, arrayStrides.data());
-        matrixStrides.reserve(count);
+        matrixStrides.resize(count);
         glGetActiveUniformsiv(this->id, count, indices.data(), GL_UNIFORM_MATRIX_STRIDE, matrixStrides.data());
-        rowMajors.reserve(count);
+        rowMajors.resize(count);
         glGetActiveUniformsiv(this->id, count, indices.data(), GL_UNIFORM_IS_ROW_MAJOR, rowMajors.data());
-        atomicCounters.reserve(count);
+        atomicCounters.resize(count);
         glGetActiveUniformsiv(this->id, count, indices.data(), GL_UNIFORM_ATOMIC_COUNTER_BUFFER_INDEX, atomicCounters.data());
         for (GLint i = 0; i < count; i++) {
             GLint length = 0;
@@ -450,7 +614,7 @@ void ShaderProgram::link() {
             buffer[length] = '\0';
             name = string(buffer.begin(), buffer.begin() + length);
             if (blocks[i] >= 0 && blocks[i] < (GLint)blockNames.size()) {
-                blockName = blockNames[i];
+                blockName = blockNames[blocks[i]];
             }
             location = glGetUniformLocation(this->id, name.c_str());
 
@@ -468,6 +632,9 @@ void ShaderProgram::link() {
         }
     }
 
+    this->bindUniformBlocks();
+    this->buildUniformShadows();
+
     {
         vector<char> buffer;
         GLint count = 0;
@@ -497,19 +664,114 @@ void ShaderProgram::link() {
     }
 }
 
+void ShaderProgram::bindUniformBlocks() const {
+    this->uniformBlockBinding("FrameConstants", ShaderProgram::frameConstantsBinding);
+    this->uniformBlockBinding("SurfaceConstants", ShaderProgram::surfaceConstantsBinding);
+}
+
+// one slot per default-block uniform, sized for its whole array so array
+// uploads through the first location are shadowed as well, the locations of
+// the other elements point back at that slot
+void ShaderProgram::buildUniformShadows() const {
+    vector<pair<GLint, GLint> > elements;
+    GLint locations = 0;
+    i32u size = 0;
+
+    for (auto it = this->uniforms.begin(); it != this->uniforms.end(); it++) {
+        const Uniform &uniform((*it).second);
+
+        locations = _max(locations, uniform.location + 1);
+        if (uniform.location >= 0 && uniform.blockName.length() == 0 && uniform.size > 1 && uniform.name.length() > 3 && uniform.name.compare(uniform.name.length() - 3, 3, "[0]") == 0) {
+            const string prefix(uniform.name.substr(0, uniform.name.length() - 3));
+
+            for (GLint i = 1; i < uniform.size; i++) {
+                stringstream element;
+                GLint location;
+
+                element << prefix << "[" << i << "]";
+                location = glGetUniformLocation(this->id, element.str().c_str());
+                if (location >= 0) {
+                    elements.push_back(make_pair(location, uniform.location));
+                    locations = _max(locations, location + 1);
+                }
+            }
+        }
+    }
+    this->shadows.assign(locations, { 0, 0, 0, false, -1 });
+    for (auto it = this->uniforms.begin(); it != this->uniforms.end(); it++) {
+        const Uniform &uniform((*it).second);
+
+        if (uniform.location >= 0 && uniform.blockName.length() == 0) {
+            UniformShadow &shadow(this->shadows[uniform.location]);
+
+            shadow.offset = size;
+            shadow.capacity = getGLTypeSize(uniform.type) * _max(uniform.size, 1);
+            shadow.base = uniform.location;
+            size += shadow.capacity;
+        }
+    }
+    for (auto it = elements.begin(); it != elements.end(); it++) {
+        this->shadows[(*it).first].base = (*it).second;
+    }
+    this->shadowData.assign(size, 0);
+}
+
+bool ShaderProgram::shadowUniform(GLint location, const GLvoid *data, i32u size, bool transpose) const {
+    if (this->shadowing && location >= 0 && location < (GLint)this->shadows.size()) {
+        UniformShadow &shadow(this->shadows[location]);
+
+        // uploads the slot cannot record make the value it holds stale
+        if (shadow.base != location) {
+            if (shadow.base >= 0) {
+                this->shadows[shadow.base].length = 0;
+            }
+        } else if (size > shadow.capacity) {
+            shadow.length = 0;
+        } else {
+            i8u *value = this->shadowData.data() + shadow.offset;
+
+            if (shadow.length == size && shadow.transpose == transpose && memcmp(value, data, size) == 0) {
+                this->skippedUploads++;
+                return false;
+            }
+            memcpy(value, data, size);
+            shadow.length = size;
+            shadow.transpose = transpose;
+        }
+    }
+    this->issuedUploads++;
+    return true;
+}
+
+bool ShaderProgram::isReady() const {
+    if (this->pending && Shader::parallelCompile()) {
+        GLint status = GL_FALSE;
+
+        glGetProgramiv(this->id, GL_COMPLETION_STATUS_KHR, &status);
+        if (!status) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool ShaderProgram::isLinked() const {
+    this->complete();
     return this->linked;
 }
 
 bool ShaderProgram::isValidated() const {
+    this->complete();
     return this->validated;
 }
 
 const string & ShaderProgram::getLinkerLogs() const {
+    this->complete();
     return this->linkerLogs;
 }
 
 const string & ShaderProgram::getValidatorLogs() const {
+    this->complete();
     return this->validatorLogs;
 }
 
@@ -518,7 +780,8 @@ void ShaderProgram::enable() {
         if (this->id == GL_ZERO) {
             return;
         }
-        glUseProgram(this->id);
+        this->complete();
+        GLState::useProgram(this->id);
     }
     this->enabled++;
 }
@@ -526,11 +789,38 @@ void ShaderProgram::enable() {
 void ShaderProgram::disable() {
     this->enabled--;
     if (this->enabled == 0) {
-        glUseProgram(GL_ZERO);
+        GLState::releaseProgram();
+    }
+}
+
+// the shadow assumes uniforms are only set through this program, turning
+// it on or off forgets every recorded value
+void ShaderProgram::setShadowing(bool shadowing) {
+    this->shadowing = shadowing;
+    for (auto it = this->shadows.begin(); it != this->shadows.end(); it++) {
+        (*it).length = 0;
     }
 }
 
+bool ShaderProgram::isShadowing() const {
+    return this->shadowing;
+}
+
+i64u ShaderProgram::getIssuedUploads() const {
+    return this->issuedUploads;
+}
+
+i64u ShaderProgram::getSkippedUploads() const {
+    return this->skippedUploads;
+}
+
+void ShaderProgram::resetUploadCounters() {
+    this->issuedUploads = 0;
+    this->skippedUploads = 0;
+}
+
 set<string> ShaderProgram::uniformBlockNames() const {
+    this->complete();
     return set<string>(
         map_key_const_iterator<map<string, UniformBlock> >(this->uniformBlocks.begin()),
         map_key_const_iterator<map<string, UniformBlock> >(this->uniformBlocks.end())
@@ -538,6 +828,7 @@ set<string> ShaderProgram::uniformBlockNames() const {
 }
 
 set<string> ShaderProgram::uniformNames() const {
+    this->complete();
     return set<string>(
         map_key_const_iterator<map<string, Uniform> >(this->uniforms.begin()),
         map_key_const_iterator<map<string, Uniform> >(this->uniforms.end())
@@ -545,6 +836,7 @@ set<string> ShaderProgram::uniformNames() const {
 }
 
 set<string> ShaderProgram::attributeNames() const {
+    this->complete();
     return set<string>(
         map_key_const_iterator<map<string, Attribute> >(this->attributes.begin()),
         map_key_const_iterator<map<string, Attribute> >(this->attributes.end())
@@ -552,6 +844,8 @@ set<string> ShaderProgram::attributeNames() const {
 }
 
 const ShaderProgram::UniformBlock & ShaderProgram::uniformBlock(const string &name) const {
+    this->complete();
+
     auto it = this->uniformBlocks.find(name);
 
     if (it != this->uniformBlocks.end()) {
@@ -561,6 +855,8 @@ const ShaderProgram::UniformBlock & ShaderProgram::uniformBlock(const string &na
 }
 
 const ShaderProgram::Uniform & ShaderProgram::uniform(const string &name) const {
+    this->complete();
+
     auto it = this->uniforms.find(name);
 
     if (it != this->uniforms.end()) {
@@ -570,6 +866,8 @@ const ShaderProgram::Uniform & ShaderProgram::uniform(const string &name) const
 }
 
 const ShaderProgram::Attribute & ShaderProgram::attribute(const string &name) const {
+    this->complete();
+
     auto it = this->attributes.find(name);
 
     if (it != this->attributes.end()) {
@@ -590,187 +888,348 @@ GLint ShaderProgram::attributeLocation(const string &name) const {
     return this->attribute(name).location;
 }
 
+void ShaderProgram::uniformBlockBinding(const string &name, GLuint binding) const {
+    this->complete();
+
+    auto it = this->uniformBlocks.find(name);
+
+    if (it == this->uniformBlocks.end()) {
+        return;
+    }
+    glUniformBlockBinding(this->id, (*it).second.index, binding);
+    (*it).second.location = binding;
+}
+
+// storage blocks are not part of the cached reflection, their binding is
+// declared in the shader
+bool ShaderProgram::hasStorageBlock(const string &name) const {
+    if (!(GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query) || !this->isLinked()) {
+        return false;
+    }
+    return glGetProgramResourceIndex(this->id, GL_SHADER_STORAGE_BLOCK, name.c_str()) != GL_INVALID_INDEX;
+}
+
+const ShaderProgram::Uniform & ShaderProgram::resolveUniform(const string &name, bool (*accepts)(GLenum type)) const {
+    const Uniform &uniform(this->uniform(name));
+
+    if (uniform.location < 0) {
+        return ShaderProgram::emptyUniform;
+    }
+    if (!accepts(uniform.type)) {
+        fprintf(stderr, "ERROR: Uniform %s is of type %s!\n", name.c_str(), getGLTypeName(uniform.type));
+        return ShaderProgram::emptyUniform;
+    }
+    return uniform;
+}
+
 void ShaderProgram::uniform(GLint location, i32 value) const {
-    glUniform1i(location, value);
+    if (!this->shadowUniform(location, &value, sizeof(value))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform1i(this->id, location, value);
+    } else {
+        glUniform1i(location, value);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Vector<i32, 2> &vec) const {
-    glUniform2i(location, vec[0], vec[1]);
+    if (!this->shadowUniform(location, &vec, sizeof(vec))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform2i(this->id, location, vec[0], vec[1]);
+    } else {
+        glUniform2i(location, vec[0], vec[1]);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Vector<i32, 3> &vec) const {
-    glUniform3i(location, vec[0], vec[1], vec[2]);
+    if (!this->shadowUniform(location, &vec, sizeof(vec))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform3i(this->id, location, vec[0], vec[1], vec[2]);
+    } else {
+        glUniform3i(location, vec[0], vec[1], vec[2]);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Vector<i32, 4> &vec) const {
-    glUniform4i(location, vec[0], vec[1], vec[2], vec[3]);
+    if (!this->shadowUniform(location, &vec, sizeof(vec))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform4i(this->id, location, vec[0], vec[1], vec[2], vec[3]);
+    } else {
+        glUniform4i(location, vec[0], vec[1], vec[2], vec[3]);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<i32> &values) const {
-    glUniform1iv(location, values.size(), values.data());
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(i32))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform1iv(this->id, location, values.size(), values.data());
+    } else {
+        glUniform1iv(location, values.size(), values.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Vector<i32, 2> > &values) const {
-    vector<i32> buffer(values.size() * 2);
-
-    for (i32u i = 0; i < values.size(); i++) {
-        buffer[i * 2 + 0] = values[i][0];
-        buffer[i * 2 + 1] = values[i][1];
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Vector<i32, 2>))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform2iv(this->id, location, values.size(), reinterpret_cast<const i32 *>(values.data()));
+    } else {
+        glUniform2iv(location, values.size(), reinterpret_cast<const i32 *>(values.data()));
     }
-    glUniform2iv(location, values.size(), buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Vector<i32, 3> > &values) const {
-    vector<i32> buffer(values.size() * 3);
-
-    for (i32u i = 0; i < values.size(); i++) {
-        buffer[i * 3 + 0] = values[i][0];
-        buffer[i * 3 + 1] = values[i][1];
-        buffer[i * 3 + 2] = values[i][2];
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Vector<i32, 3>))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform3iv(this->id, location, values.size(), reinterpret_cast<const i32 *>(values.data()));
+    } else {
+        glUniform3iv(location, values.size(), reinterpret_cast<const i32 *>(values.data()));
     }
-    glUniform3iv(location, values.size(), buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Vector<i32, 4> > &values) const {
-    vector<i32> buffer(values.size() * 4);
-
-    for (i32u i = 0; i < values.size(); i++) {
-        buffer[i * 4 + 0] = values[i][0];
-        buffer[i * 4 + 1] = values[i][1];
-        buffer[i * 4 + 2] = values[i][2];
-        buffer[i * 4 + 3] = values[i][3];
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Vector<i32, 4>))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform4iv(this->id, location, values.size(), reinterpret_cast<const i32 *>(values.data()));
+    } else {
+        glUniform4iv(location, values.size(), reinterpret_cast<const i32 *>(values.data()));
     }
-    glUniform4iv(location, values.size(), buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, f32 value) const {
-    glUniform1f(location, value);
+    if (!this->shadowUniform(location, &value, sizeof(value))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform1f(this->id, location, value);
+    } else {
+        glUniform1f(location, value);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Vector<f32, 2> &vec) const {
-    glUniform2f(location, vec[0], vec[1]);
+    if (!this->shadowUniform(location, &vec, sizeof(vec))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform2f(this->id, location, vec[0], vec[1]);
+    } else {
+        glUniform2f(location, vec[0], vec[1]);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Vector<f32, 3> &vec) const {
-    glUniform3f(location, vec[0], vec[1], vec[2]);
+    if (!this->shadowUniform(location, &vec, sizeof(vec))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform3f(this->id, location, vec[0], vec[1], vec[2]);
+    } else {
+        glUniform3f(location, vec[0], vec[1], vec[2]);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Vector<f32, 4> &vec) const {
-    glUniform4f(location, vec[0], vec[1], vec[2], vec[3]);
+    if (!this->shadowUniform(location, &vec, sizeof(vec))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform4f(this->id, location, vec[0], vec[1], vec[2], vec[3]);
+    } else {
+        glUniform4f(location, vec[0], vec[1], vec[2], vec[3]);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<f32> &values) const {
-    glUniform1fv(location, values.size(), values.data());
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(f32))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform1fv(this->id, location, values.size(), values.data());
+    } else {
+        glUniform1fv(location, values.size(), values.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Vector<f32, 2> > &values) const {
-    vector<f32> buffer(values.size() * 2);
-    f32 *ptr = buffer.data();
-
-    for (i32u i = 0; i < values.size(); i++) {
-        values[i].copy(ptr);
-        ptr += 2;
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Vector<f32, 2>))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform2fv(this->id, location, values.size(), reinterpret_cast<const f32 *>(values.data()));
+    } else {
+        glUniform2fv(location, values.size(), reinterpret_cast<const f32 *>(values.data()));
     }
-    glUniform2fv(location, values.size(), buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Vector<f32, 3> > &values) const {
-    vector<f32> buffer(values.size() * 3);
-    f32 *ptr = buffer.data();
-
-    for (i32u i = 0; i < values.size(); i++) {
-        values[i].copy(ptr);
-        ptr += 3;
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Vector<f32, 3>))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform3fv(this->id, location, values.size(), reinterpret_cast<const f32 *>(values.data()));
+    } else {
+        glUniform3fv(location, values.size(), reinterpret_cast<const f32 *>(values.data()));
     }
-    glUniform3fv(location, values.size(), buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Vector<f32, 4> > &values) const {
-    vector<f32> buffer(values.size() * 4);
-    f32 *ptr = buffer.data();
-
-    for (i32u i = 0; i < values.size(); i++) {
-        values[i].copy(ptr);
-        ptr += 4;
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Vector<f32, 4>))) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniform4fv(this->id, location, values.size(), reinterpret_cast<const f32 *>(values.data()));
+    } else {
+        glUniform4fv(location, values.size(), reinterpret_cast<const f32 *>(values.data()));
     }
-    glUniform4fv(location, values.size(), buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 2, 2> &matrix, bool transpose) const {
-    f32 buffer[4];
-
-    matrix.copyTransposed(buffer);
-    glUniformMatrix2fv(location, 1, transpose, buffer);
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix2fv(this->id, location, 1, !transpose, matrix);
+    } else {
+        glUniformMatrix2fv(location, 1, !transpose, matrix);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 2, 3> &matrix, bool transpose) const {
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
     f32 buffer[6];
 
     matrix.copyTransposed(buffer);
-    glUniformMatrix2x3fv(location, 1, transpose, buffer);
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix2x3fv(this->id, location, 1, transpose, buffer);
+    } else {
+        glUniformMatrix2x3fv(location, 1, transpose, buffer);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 2, 4> &matrix, bool transpose) const {
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
     f32 buffer[8];
 
     matrix.copyTransposed(buffer);
-    glUniformMatrix2x4fv(location, 1, transpose, buffer);
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix2x4fv(this->id, location, 1, transpose, buffer);
+    } else {
+        glUniformMatrix2x4fv(location, 1, transpose, buffer);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 3, 2> &matrix, bool transpose) const {
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
     f32 buffer[6];
 
     matrix.copyTransposed(buffer);
-    glUniformMatrix3x2fv(location, 1, transpose, buffer);
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix3x2fv(this->id, location, 1, transpose, buffer);
+    } else {
+        glUniformMatrix3x2fv(location, 1, transpose, buffer);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 3, 3> &matrix, bool transpose) const {
-    f32 buffer[9];
-
-    matrix.copyTransposed(buffer);
-    glUniformMatrix3fv(location, 1, transpose, buffer);
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix3fv(this->id, location, 1, !transpose, matrix);
+    } else {
+        glUniformMatrix3fv(location, 1, !transpose, matrix);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 3, 4> &matrix, bool transpose) const {
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
     f32 buffer[12];
 
     matrix.copyTransposed(buffer);
-    glUniformMatrix3x4fv(location, 1, transpose, buffer);
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix3x4fv(this->id, location, 1, transpose, buffer);
+    } else {
+        glUniformMatrix3x4fv(location, 1, transpose, buffer);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 4, 2> &matrix, bool transpose) const {
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
     f32 buffer[8];
 
     matrix.copyTransposed(buffer);
-    glUniformMatrix4x2fv(location, 1, transpose, buffer);
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix4x2fv(this->id, location, 1, transpose, buffer);
+    } else {
+        glUniformMatrix4x2fv(location, 1, transpose, buffer);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 4, 3> &matrix, bool transpose) const {
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
     f32 buffer[12];
 
     matrix.copyTransposed(buffer);
-    glUniformMatrix4x3fv(location, 1, transpose, buffer);
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix4x3fv(this->id, location, 1, transpose, buffer);
+    } else {
+        glUniformMatrix4x3fv(location, 1, transpose, buffer);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const Matrix<f32, 4, 4> &matrix, bool transpose) const {
-    f32 buffer[16];
-
-    matrix.copyTransposed(buffer);
-    glUniformMatrix4fv(location, 1, transpose, buffer);
+    if (!this->shadowUniform(location, &matrix, sizeof(matrix), transpose)) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix4fv(this->id, location, 1, !transpose, matrix);
+    } else {
+        glUniformMatrix4fv(location, 1, !transpose, matrix);
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 2, 2> > &values, bool transpose) const {
-    vector<f32> buffer(values.size() * 4);
-    f32 *ptr = buffer.data();
-
-    for (i32u i = 0; i < values.size(); i++) {
-        values[i].copyTransposed(ptr);
-        ptr += 4;
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 2, 2>), transpose)) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix2fv(this->id, location, values.size(), !transpose, reinterpret_cast<const f32 *>(values.data()));
+    } else {
+        glUniformMatrix2fv(location, values.size(), !transpose, reinterpret_cast<const f32 *>(values.data()));
     }
-    glUniformMatrix2fv(location, values.size(), transpose, buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 2, 3> > &values, bool transpose) const {
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 2, 3>), transpose)) {
+        return;
+    }
     vector<f32> buffer(values.size() * 6);
     f32 *ptr = buffer.data();
 
@@ -778,10 +1237,17 @@ void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 2, 3> > &va
         values[i].copyTransposed(ptr);
         ptr += 6;
     }
-    glUniformMatrix2x3fv(location, values.size(), transpose, buffer.data());
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix2x3fv(this->id, location, values.size(), transpose, buffer.data());
+    } else {
+        glUniformMatrix2x3fv(location, values.size(), transpose, buffer.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 2, 4> > &values, bool transpose) const {
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 2, 4>), transpose)) {
+        return;
+    }
     vector<f32> buffer(values.size() * 8);
     f32 *ptr = buffer.data();
 
@@ -789,10 +1255,17 @@ void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 2, 4> > &va
         values[i].copyTransposed(ptr);
         ptr += 8;
     }
-    glUniformMatrix2x4fv(location, values.size(), transpose, buffer.data());
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix2x4fv(this->id, location, values.size(), transpose, buffer.data());
+    } else {
+        glUniformMatrix2x4fv(location, values.size(), transpose, buffer.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 3, 2> > &values, bool transpose) const {
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 3, 2>), transpose)) {
+        return;
+    }
     vector<f32> buffer(values.size() * 6);
     f32 *ptr = buffer.data();
 
@@ -800,21 +1273,28 @@ void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 3, 2> > &va
         values[i].copyTransposed(ptr);
         ptr += 6;
     }
-    glUniformMatrix3x2fv(location, values.size(), transpose, buffer.data());
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix3x2fv(this->id, location, values.size(), transpose, buffer.data());
+    } else {
+        glUniformMatrix3x2fv(location, values.size(), transpose, buffer.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 3, 3> > &values, bool transpose) const {
-    vector<f32> buffer(values.size() * 9);
-    f32 *ptr = buffer.data();
-
-    for (i32u i = 0; i < values.size(); i++) {
-        values[i].copyTransposed(ptr);
-        ptr += 9;
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 3, 3>), transpose)) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix3fv(this->id, location, values.size(), !transpose, reinterpret_cast<const f32 *>(values.data()));
+    } else {
+        glUniformMatrix3fv(location, values.size(), !transpose, reinterpret_cast<const f32 *>(values.data()));
     }
-    glUniformMatrix3fv(location, values.size(), transpose, buffer.data());
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 3, 4> > &values, bool transpose) const {
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 3, 4>), transpose)) {
+        return;
+    }
     vector<f32> buffer(values.size() * 12);
     f32 *ptr = buffer.data();
 
@@ -822,10 +1302,17 @@ void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 3, 4> > &va
         values[i].copyTransposed(ptr);
         ptr += 12;
     }
-    glUniformMatrix3x4fv(location, values.size(), transpose, buffer.data());
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix3x4fv(this->id, location, values.size(), transpose, buffer.data());
+    } else {
+        glUniformMatrix3x4fv(location, values.size(), transpose, buffer.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 4, 2> > &values, bool transpose) const {
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 4, 2>), transpose)) {
+        return;
+    }
     vector<f32> buffer(values.size() * 8);
     f32 *ptr = buffer.data();
 
@@ -833,10 +1320,17 @@ void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 4, 2> > &va
         values[i].copyTransposed(ptr);
         ptr += 8;
     }
-    glUniformMatrix4x2fv(location, values.size(), transpose, buffer.data());
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix4x2fv(this->id, location, values.size(), transpose, buffer.data());
+    } else {
+        glUniformMatrix4x2fv(location, values.size(), transpose, buffer.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 4, 3> > &values, bool transpose) const {
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 4, 3>), transpose)) {
+        return;
+    }
     vector<f32> buffer(values.size() * 12);
     f32 *ptr = buffer.data();
 
@@ -844,20 +1338,194 @@ void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 4, 3> > &va
         values[i].copyTransposed(ptr);
         ptr += 12;
     }
-    glUniformMatrix4x3fv(location, values.size(), transpose, buffer.data());
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix4x3fv(this->id, location, values.size(), transpose, buffer.data());
+    } else {
+        glUniformMatrix4x3fv(location, values.size(), transpose, buffer.data());
+    }
 }
 
 void ShaderProgram::uniform(GLint location, const vector<Matrix<f32, 4, 4> > &values, bool transpose) const {
-    vector<f32> buffer(values.size() * 16);
-    f32 *ptr = buffer.data();
+    if (!this->shadowUniform(location, values.data(), values.size() * sizeof(Matrix<f32, 4, 4>), transpose)) {
+        return;
+    }
+    if (GLState::directStateAccess()) {
+        glProgramUniformMatrix4fv(this->id, location, values.size(), !transpose, reinterpret_cast<const f32 *>(values.data()));
+    } else {
+        glUniformMatrix4fv(location, values.size(), !transpose, reinterpret_cast<const f32 *>(values.data()));
+    }
+}
 
-    for (i32u i = 0; i < values.size(); i++) {
-        values[i].copyTransposed(ptr);
-        ptr += 16;
+template<typename T>
+static void writeValue(ostream &stream, const T &value) {
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static void writeString(ostream &stream, const string &value) {
+    writeValue<i32u>(stream, value.length());
+    stream.write(value.data(), value.length());
+}
+
+template<typename T>
+static bool readValue(istream &stream, T &value) {
+    return (bool)stream.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+static bool readString(istream &stream, string &value) {
+    i32u length = 0;
+
+    if (!readValue(stream, length) || length > 0xffff) {
+        return false;
     }
-    glUniformMatrix4x3fv(location, values.size(), transpose, buffer.data());
+    value.resize(length);
+    return length == 0 || (bool)stream.read(&value[0], length);
 }
 
+// binary blob followed by the reflection tables, so a reload skips link()
+bool ShaderProgram::saveBinary(ostream &stream) const {
+    vector<char> binary;
+    GLint length = 0;
+    GLenum format = GL_ZERO;
+
+    if (!this->isLinked()) {
+        return false;
+    }
+    glGetProgramiv(this->id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+    binary.resize(length);
+    glGetProgramBinary(this->id, length, &length, &format, binary.data());
+    if (length <= 0) {
+        return false;
+    }
+
+    writeValue<GLenum>(stream, format);
+    writeValue<i32u>(stream, length);
+    stream.write(binary.data(), length);
+
+    writeValue<i32u>(stream, this->uniformBlocks.size());
+    for_each(this->uniformBlocks.begin(), this->uniformBlocks.end(), [&stream] (const pair<const string, UniformBlock> &entry) {
+        const UniformBlock &block(entry.second);
+
+        writeString(stream, block.name);
+        writeValue(stream, block.index);
+        writeValue(stream, block.location);
+        writeValue(stream, block.uniforms);
+        writeValue(stream, block.size);
+    });
+    writeValue<i32u>(stream, this->uniforms.size());
+    for_each(this->uniforms.begin(), this->uniforms.end(), [&stream] (const pair<const string, Uniform> &entry) {
+        const Uniform &uniform(entry.second);
+
+        writeString(stream, uniform.name);
+        writeValue(stream, uniform.location);
+        writeValue(stream, uniform.type);
+        writeValue(stream, uniform.size);
+        writeString(stream, uniform.blockName);
+        writeValue(stream, uniform.blockOffset);
+        writeValue(stream, uniform.arrayStride);
+        writeValue(stream, uniform.matrixStride);
+        writeValue<i8u>(stream, uniform.rowMajor ? 1 : 0);
+    });
+    writeValue<i32u>(stream, this->attributes.size());
+    for_each(this->attributes.begin(), this->attributes.end(), [&stream] (const pair<const string, Attribute> &entry) {
+        const Attribute &attribute(entry.second);
+
+        writeString(stream, attribute.name);
+        writeValue(stream, attribute.location);
+        writeValue(stream, attribute.type);
+        writeValue(stream, attribute.size);
+    });
+    return (bool)stream;
+}
+
+shared_ptr<ShaderProgram> ShaderProgram::loadBinary(istream &stream) {
+    shared_ptr<ShaderProgram> program(new ShaderProgram());
+    vector<char> binary;
+    GLenum format = GL_ZERO;
+    i32u length = 0;
+    i32u count = 0;
+
+    if (!readValue(stream, format) || !readValue(stream, length) || length == 0 || length > 0x4000000) {
+        return shared_ptr<ShaderProgram>();
+    }
+    binary.resize(length);
+    if (!stream.read(binary.data(), length)) {
+        return shared_ptr<ShaderProgram>();
+    }
+
+    if (!readValue(stream, count)) {
+        return shared_ptr<ShaderProgram>();
+    }
+    for (i32u i = 0; i < count; i++) {
+        UniformBlock block;
+
+        if (!readString(stream, block.name) || !readValue(stream, block.index) || !readValue(stream, block.location) ||
+            !readValue(stream, block.uniforms) || !readValue(stream, block.size)) {
+            return shared_ptr<ShaderProgram>();
+        }
+        program->uniformBlocks[block.name] = block;
+    }
+    if (!readValue(stream, count)) {
+        return shared_ptr<ShaderProgram>();
+    }
+    for (i32u i = 0; i < count; i++) {
+        Uniform uniform;
+        i8u rowMajor = 0;
+
+        if (!readString(stream, uniform.name) || !readValue(stream, uniform.location) || !readValue(stream, uniform.type) ||
+            !readValue(stream, uniform.size) || !readString(stream, uniform.blockName) || !readValue(stream, uniform.blockOffset) ||
+            !readValue(stream, uniform.arrayStride) || !readValue(stream, uniform.matrixStride) || !readValue(stream, rowMajor)) {
+            return shared_ptr<ShaderProgram>();
+        }
+        uniform.rowMajor = rowMajor ? true : false;
+        program->uniforms[uniform.name] = uniform;
+    }
+    if (!readValue(stream, count)) {
+        return shared_ptr<ShaderProgram>();
+    }
+    for (i32u i = 0; i < count; i++) {
+        Attribute attribute;
+
+        if (!readString(stream, attribute.name) || !readValue(stream, attribute.location) || !readValue(stream, attribute.type) ||
+            !readValue(stream, attribute.size)) {
+            return shared_ptr<ShaderProgram>();
+        }
+        program->attributes[attribute.name] = attribute;
+    }
+
+    program->id = glCreateProgram();
+    if (program->id == GL_ZERO) {
+        return shared_ptr<ShaderProgram>();
+    }
+    glProgramBinary(program->id, format, binary.data(), length);
+    {
+        GLint status = GL_FALSE;
+
+        glGetProgramiv(program->id, GL_LINK_STATUS, &status);
+        if (!status) {
+            return shared_ptr<ShaderProgram>();
+        }
+        program->linked = true;
+    }
+
+    glValidateProgram(program->id);
+    {
+        GLint status = GL_FALSE;
+
+        glGetProgramiv(program->id, GL_VALIDATE_STATUS, &status);
+        if (status) {
+            program->validated = true;
+        }
+    }
+
+    program->bindUniformBlocks();
+    program->buildUniformShadows();
+    return program;
+}
+
+
 void ShaderProgram::print() const {
     auto bNames(this->uniformBlockNames());
     auto uNames(this->uniformNames());
@@ -880,6 +1548,7 @@ void ShaderProgram::print() const {
         auto block(this->uniformBlock(name));
 
         printf("block[%s]\n", block.name.c_str());
+        printf(" index: %u\n", block.index);
         printf(" location: %d\n", block.location);
         printf(" uniforms: %d\n", block.uniforms);
         printf(" size: %d\n", block.size);
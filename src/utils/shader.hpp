@@ -32,8 +32,12 @@ protected:
 
 
     GLuint id;
-    bool compiled;
-    string logs;
+    mutable bool pending;
+    mutable bool compiled;
+    mutable string logs;
+
+
+    void complete() const;
 
 
 public:
@@ -41,15 +45,85 @@ public:
     const string source;
 
 
-    Shader(GLenum type, const string &source);
+    Shader(GLenum type, const string &source, bool deferred = false);
     ~Shader();
 
 
+    bool isReady() const;
     bool isCompiled() const;
     const string & getLogs() const;
 
 
-    static shared_ptr<Shader> fromFile(GLenum type, const string &path);
+    static bool parallelCompile();
+
+    static string readFile(const string &path);
+    static shared_ptr<Shader> fromFile(GLenum type, const string &path, bool deferred = false);
+};
+
+
+bool isGLSamplerType(GLenum type);
+
+
+// GL type reported by reflection for each uniform value type
+template<GLenum T>
+struct GLUniformTypeOf {
+    static const GLenum type = T;
+
+    static inline bool accepts(GLenum type) {
+        return type == T;
+    }
+};
+
+template<typename VT>
+struct GLUniformType;
+
+template<>
+struct GLUniformType<i32> : GLUniformTypeOf<GL_INT> {
+    static inline bool accepts(GLenum type) {
+        return type == GL_INT || type == GL_BOOL || isGLSamplerType(type);
+    }
+};
+
+template<> struct GLUniformType<Vector<i32, 2> > : GLUniformTypeOf<GL_INT_VEC2> {};
+template<> struct GLUniformType<Vector<i32, 3> > : GLUniformTypeOf<GL_INT_VEC3> {};
+template<> struct GLUniformType<Vector<i32, 4> > : GLUniformTypeOf<GL_INT_VEC4> {};
+template<> struct GLUniformType<f32> : GLUniformTypeOf<GL_FLOAT> {};
+template<> struct GLUniformType<Vector<f32, 2> > : GLUniformTypeOf<GL_FLOAT_VEC2> {};
+template<> struct GLUniformType<Vector<f32, 3> > : GLUniformTypeOf<GL_FLOAT_VEC3> {};
+template<> struct GLUniformType<Vector<f32, 4> > : GLUniformTypeOf<GL_FLOAT_VEC4> {};
+template<> struct GLUniformType<Matrix<f32, 2, 2> > : GLUniformTypeOf<GL_FLOAT_MAT2> {};
+template<> struct GLUniformType<Matrix<f32, 2, 3> > : GLUniformTypeOf<GL_FLOAT_MAT2x3> {};
+template<> struct GLUniformType<Matrix<f32, 2, 4> > : GLUniformTypeOf<GL_FLOAT_MAT2x4> {};
+template<> struct GLUniformType<Matrix<f32, 3, 2> > : GLUniformTypeOf<GL_FLOAT_MAT3x2> {};
+template<> struct GLUniformType<Matrix<f32, 3, 3> > : GLUniformTypeOf<GL_FLOAT_MAT3> {};
+template<> struct GLUniformType<Matrix<f32, 3, 4> > : GLUniformTypeOf<GL_FLOAT_MAT3x4> {};
+template<> struct GLUniformType<Matrix<f32, 4, 2> > : GLUniformTypeOf<GL_FLOAT_MAT4x2> {};
+template<> struct GLUniformType<Matrix<f32, 4, 3> > : GLUniformTypeOf<GL_FLOAT_MAT4x3> {};
+template<> struct GLUniformType<Matrix<f32, 4, 4> > : GLUniformTypeOf<GL_FLOAT_MAT4> {};
+
+template<typename VT>
+struct GLUniformType<vector<VT> > : GLUniformType<VT> {
+};
+
+
+// uniform location resolved once, setting through it skips the name lookup
+template<typename VT>
+class UniformHandle {
+public:
+    GLint location;
+    GLenum type;
+
+
+    inline UniformHandle() : location(-1), type(GL_ZERO) {
+    }
+
+    inline UniformHandle(GLint location, GLenum type) : location(location), type(type) {
+    }
+
+
+    inline bool isValid() const {
+        return this->location >= 0;
+    }
 };
 
 
@@ -57,6 +131,7 @@ class ShaderProgram {
 public:
     typedef struct {
         string name;
+        GLuint index;
         GLint location;
         GLint uniforms;
         GLint size;
@@ -82,6 +157,24 @@ public:
         GLint size;
     } Attribute;
 
+    // last value uploaded to a default-block uniform, indexed by location,
+    // base is the location of the uniform whose value the location holds
+    typedef struct {
+        i32u offset;
+        i32u capacity;
+        i32u length;
+        bool transpose;
+        GLint base;
+    } UniformShadow;
+
+
+    // binding point of the per-frame camera block filled by the renderer
+    static const GLuint frameConstantsBinding = 0;
+    // binding point of the per-draw slice of the SurfaceConstants block
+    static const GLuint surfaceConstantsBinding = 1;
+    // binding point of the per-draw transforms of batched draws
+    static const GLuint drawTransformsBinding = 2;
+
 
 protected:
     static const UniformBlock emptyUniformBlock;
@@ -89,27 +182,48 @@ protected:
     static const Attribute emptyAttribute;
 
 
+    // link status and reflection are filled in by complete(), which
+    // deferred programs only run once the driver is done
     GLuint id;
-    bool linked;
-    bool validated;
+    mutable bool pending;
+    mutable bool linked;
+    mutable bool validated;
     i32 enabled;
     list<shared_ptr<Shader> > shaders;
-    string linkerLogs;
-    string validatorLogs;
-    map<string, UniformBlock> uniformBlocks;
-    map<string, Uniform> uniforms;
-    map<string, Attribute> attributes;
+    mutable string linkerLogs;
+    mutable string validatorLogs;
+    mutable map<string, UniformBlock> uniformBlocks;
+    mutable map<string, Uniform> uniforms;
+    mutable map<string, Attribute> attributes;
+    bool shadowing;
+    mutable vector<UniformShadow> shadows;
+    mutable vector<i8u> shadowData;
+    mutable i64u issuedUploads;
+    mutable i64u skippedUploads;
+
 
+    ShaderProgram();
 
-    void link();
+    void link(bool deferred);
+    void complete() const;
+    void bindUniformBlocks() const;
+    void buildUniformShadows() const;
+    bool shadowUniform(GLint location, const GLvoid *data, i32u size, bool transpose = false) const;
+
+    const Uniform & resolveUniform(const string &name, bool (*accepts)(GLenum type)) const;
 
 
 public:
-    ShaderProgram(const shared_ptr<Shader> &vertexShader, const shared_ptr<Shader> &fragmentShader);
-    ShaderProgram(const list<shared_ptr<Shader> > &shaders);
+    ShaderProgram(const shared_ptr<Shader> &vertexShader, const shared_ptr<Shader> &fragmentShader, bool deferred = false);
+    ShaderProgram(const list<shared_ptr<Shader> > &shaders, bool deferred = false);
     ~ShaderProgram();
 
 
+    inline GLuint handle() const {
+        return this->id;
+    }
+
+    bool isReady() const;
     bool isLinked() const;
     bool isValidated() const;
     const string & getLinkerLogs() const;
@@ -118,6 +232,12 @@ public:
     void enable();
     void disable();
 
+    void setShadowing(bool shadowing);
+    bool isShadowing() const;
+    i64u getIssuedUploads() const;
+    i64u getSkippedUploads() const;
+    void resetUploadCounters();
+
     set<string> uniformBlockNames() const;
     set<string> uniformNames() const;
     set<string> attributeNames() const;
@@ -130,6 +250,33 @@ public:
     GLint uniformLocation(const string &name) const;
     GLint attributeLocation(const string &name) const;
 
+    void uniformBlockBinding(const string &name, GLuint binding) const;
+
+    bool hasStorageBlock(const string &name) const;
+
+
+    template<typename VT>
+    inline UniformHandle<VT> uniformHandle(const string &name) const {
+        const Uniform &uniform(this->resolveUniform(name, GLUniformType<VT>::accepts));
+
+        return UniformHandle<VT>(uniform.location, uniform.type);
+    }
+
+    template<typename VT>
+    inline void uniform(const UniformHandle<VT> &handle, const VT &value) const {
+        if (handle.location >= 0) {
+            this->uniform(handle.location, value);
+        }
+    }
+
+    template<typename VT>
+    inline void uniform(const UniformHandle<VT> &handle, const VT &value, bool transpose) const {
+        if (handle.location >= 0) {
+            this->uniform(handle.location, value, transpose);
+        }
+    }
+
+
     void uniform(GLint location, i32 value) const;
     void uniform(GLint location, const Vector<i32, 2> &vec) const;
     void uniform(GLint location, const Vector<i32, 3> &vec) const;
@@ -442,6 +589,10 @@ public:
     }
 
 
+    bool saveBinary(ostream &stream) const;
+    static shared_ptr<ShaderProgram> loadBinary(istream &stream);
+
+
     void print() const;
 };
 
@@ -0,0 +1,348 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#include "archifake.hpp"
+
+
+bool RenderState::operator == (const RenderState &state) const {
+    return
+        this->depthTest == state.depthTest &&
+        this->depthFunc == state.depthFunc &&
+        this->depthWrite == state.depthWrite &&
+        this->cullFace == state.cullFace &&
+        this->cullMode == state.cullMode &&
+        this->blend == state.blend &&
+        this->blendSource == state.blendSource &&
+        this->blendDestination == state.blendDestination;
+}
+
+// depth tested and back faces culled
+RenderState RenderState::opaque() {
+    RenderState state;
+
+    state.depthTest = true;
+    state.depthFunc = GL_LEQUAL;
+    state.cullFace = true;
+    state.cullMode = GL_BACK;
+    return state;
+}
+
+// alpha blended over what is behind, without hiding it in the depth buffer
+RenderState RenderState::translucent() {
+    RenderState state(RenderState::opaque());
+
+    state.depthWrite = false;
+    state.blend = true;
+    state.blendSource = GL_SRC_ALPHA;
+    state.blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+    return state;
+}
+
+
+const GLuint GLState::unknown;
+
+map<GLenum, GLuint> GLState::buffers;
+map<pair<GLenum, GLuint>, GLState::IndexedBinding> GLState::indexedBuffers;
+GLuint GLState::vertexArray = GLState::unknown;
+GLuint GLState::program = GLState::unknown;
+GLuint GLState::textureUnit = GLState::unknown;
+vector<map<GLenum, GLuint> > GLState::textures;
+map<GLenum, GLuint> GLState::capabilities;
+GLuint GLState::depthFunction = GLState::unknown;
+GLuint GLState::depthWrite = GLState::unknown;
+GLuint GLState::cullMode = GLState::unknown;
+GLuint GLState::blendSource = GLState::unknown;
+GLuint GLState::blendDestination = GLState::unknown;
+
+i64u GLState::issuedCalls = 0;
+i64u GLState::elidedCalls = 0;
+i64u GLState::lastIssuedCalls = 0;
+i64u GLState::lastElidedCalls = 0;
+
+
+GLuint & GLState::buffer(GLenum target) {
+    auto it = GLState::buffers.find(target);
+
+    if (it == GLState::buffers.end()) {
+        it = GLState::buffers.insert(make_pair(target, GLState::unknown)).first;
+    }
+    return (*it).second;
+}
+
+GLuint & GLState::texture(GLenum target) {
+    GLuint unit = GLState::textureUnit == GLState::unknown ? 0 : GLState::textureUnit;
+
+    if (GLState::textures.size() <= unit) {
+        GLState::textures.resize(unit + 1);
+    }
+
+    auto &bindings(GLState::textures[unit]);
+    auto it = bindings.find(target);
+
+    if (it == bindings.end()) {
+        it = bindings.insert(make_pair(target, GLState::unknown)).first;
+    }
+    return (*it).second;
+}
+
+GLuint & GLState::capability(GLenum cap) {
+    auto it = GLState::capabilities.find(cap);
+
+    if (it == GLState::capabilities.end()) {
+        it = GLState::capabilities.insert(make_pair(cap, GLState::unknown)).first;
+    }
+    return (*it).second;
+}
+
+
+// GL 4.5 or ARB_direct_state_access, resources are then edited by name
+// without going through the bindings
+bool GLState::directStateAccess() {
+    static i32 supported = -1;
+
+    if (supported < 0) {
+        supported = GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access ? 1 : 0;
+    }
+    return supported > 0;
+}
+
+
+// must be called whenever the context is made current or touched by code
+// that does not go through this class
+void GLState::invalidate() {
+    GLState::buffers.clear();
+    GLState::indexedBuffers.clear();
+    GLState::vertexArray = GLState::unknown;
+    GLState::program = GLState::unknown;
+    GLState::textureUnit = GLState::unknown;
+    GLState::textures.clear();
+    GLState::capabilities.clear();
+    GLState::depthFunction = GLState::unknown;
+    GLState::depthWrite = GLState::unknown;
+    GLState::cullMode = GLState::unknown;
+    GLState::blendSource = GLState::unknown;
+    GLState::blendDestination = GLState::unknown;
+}
+
+void GLState::endFrame() {
+    GLState::lastIssuedCalls = GLState::issuedCalls;
+    GLState::lastElidedCalls = GLState::elidedCalls;
+    GLState::issuedCalls = 0;
+    GLState::elidedCalls = 0;
+}
+
+i64u GLState::getIssuedCalls() {
+    return GLState::lastIssuedCalls;
+}
+
+i64u GLState::getElidedCalls() {
+    return GLState::lastElidedCalls;
+}
+
+
+void GLState::bindBuffer(GLenum target, GLuint id) {
+    if (GLState::update(GLState::buffer(target), id)) {
+        glBindBuffer(target, id);
+    }
+}
+
+// pixel transfer buffers turn client pointers into offsets, they cannot
+// stay bound behind the back of the caller
+void GLState::unbindBuffer(GLenum target) {
+    if (target == GL_PIXEL_PACK_BUFFER || target == GL_PIXEL_UNPACK_BUFFER) {
+        GLState::bindBuffer(target, GL_ZERO);
+    } else {
+        GLState::elidedCalls++;
+    }
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint id) {
+    GLState::bindBufferRange(target, index, id, 0, 0);
+}
+
+// indexed binds also replace the generic binding of the target
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint id, i32u offset, i32u size) {
+    IndexedBinding &binding(GLState::indexedBuffers[make_pair(target, index)]);
+
+    if (binding.id == id && binding.offset == offset && binding.size == size && id != GL_ZERO) {
+        GLState::elidedCalls++;
+        return;
+    }
+    binding.id = id;
+    binding.offset = offset;
+    binding.size = size;
+    if (size == 0) {
+        glBindBufferBase(target, index, id);
+    } else {
+        glBindBufferRange(target, index, id, offset, size);
+    }
+    GLState::buffer(target) = id;
+    GLState::issuedCalls++;
+}
+
+// deleting a bound buffer reverts its bindings to zero
+void GLState::deleteBuffer(GLuint id) {
+    glDeleteBuffers(1, &id);
+    for (auto it = GLState::buffers.begin(); it != GLState::buffers.end(); it++) {
+        if ((*it).second == id) {
+            (*it).second = GL_ZERO;
+        }
+    }
+    for (auto it = GLState::indexedBuffers.begin(); it != GLState::indexedBuffers.end(); it++) {
+        if ((*it).second.id == id) {
+            (*it).second.id = GL_ZERO;
+        }
+    }
+}
+
+
+// the element buffer binding belongs to the vertex array, so it is unknown
+// again after every change; unbinding a vertex array is never deferred since
+// an element buffer bound afterwards would end up inside it
+void GLState::bindVertexArray(GLuint id) {
+    if (GLState::update(GLState::vertexArray, id)) {
+        glBindVertexArray(id);
+        GLState::buffer(GL_ELEMENT_ARRAY_BUFFER) = GLState::unknown;
+    }
+}
+
+void GLState::deleteVertexArray(GLuint id) {
+    glDeleteVertexArrays(1, &id);
+    if (GLState::vertexArray == id) {
+        GLState::vertexArray = GL_ZERO;
+        GLState::buffer(GL_ELEMENT_ARRAY_BUFFER) = GLState::unknown;
+    }
+}
+
+
+void GLState::useProgram(GLuint id) {
+    if (GLState::update(GLState::program, id)) {
+        glUseProgram(id);
+    }
+}
+
+void GLState::releaseProgram() {
+    GLState::elidedCalls++;
+}
+
+// a deleted program stays alive while current, release it for real so
+// its name cannot come back while still cached
+void GLState::deleteProgram(GLuint id) {
+    if (GLState::program == id) {
+        GLState::useProgram(GL_ZERO);
+    }
+    glDeleteProgram(id);
+}
+
+
+void GLState::activeTexture(GLuint unit) {
+    if (GLState::update(GLState::textureUnit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void GLState::bindTexture(GLenum target, GLuint id) {
+    if (GLState::update(GLState::texture(target), id)) {
+        glBindTexture(target, id);
+    }
+}
+
+void GLState::unbindTexture(GLenum target) {
+    GLState::elidedCalls++;
+}
+
+void GLState::deleteTexture(GLuint id) {
+    glDeleteTextures(1, &id);
+    for (auto unit = GLState::textures.begin(); unit != GLState::textures.end(); unit++) {
+        for (auto it = (*unit).begin(); it != (*unit).end(); it++) {
+            if ((*it).second == id) {
+                (*it).second = GL_ZERO;
+            }
+        }
+    }
+}
+
+
+void GLState::enable(GLenum cap) {
+    if (GLState::update(GLState::capability(cap), GL_TRUE)) {
+        glEnable(cap);
+    }
+}
+
+void GLState::disable(GLenum cap) {
+    if (GLState::update(GLState::capability(cap), GL_FALSE)) {
+        glDisable(cap);
+    }
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (GLState::update(GLState::depthFunction, func)) {
+        glDepthFunc(func);
+    }
+}
+
+void GLState::depthMask(bool write) {
+    if (GLState::update(GLState::depthWrite, write ? GL_TRUE : GL_FALSE)) {
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void GLState::cullFace(GLenum mode) {
+    if (GLState::update(GLState::cullMode, mode)) {
+        glCullFace(mode);
+    }
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    if (GLState::blendSource == source && GLState::blendDestination == destination) {
+        GLState::elidedCalls++;
+        return;
+    }
+    GLState::blendSource = source;
+    GLState::blendDestination = destination;
+    GLState::issuedCalls++;
+    glBlendFunc(source, destination);
+}
+
+// only the differences with the current state reach GL, the functions of
+// disabled tests are left alone
+void GLState::applyRenderState(const RenderState &state) {
+    if (state.depthTest) {
+        GLState::enable(GL_DEPTH_TEST);
+        GLState::depthFunc(state.depthFunc);
+    } else {
+        GLState::disable(GL_DEPTH_TEST);
+    }
+    GLState::depthMask(state.depthWrite);
+    if (state.cullFace) {
+        GLState::enable(GL_CULL_FACE);
+        GLState::cullFace(state.cullMode);
+    } else {
+        GLState::disable(GL_CULL_FACE);
+    }
+    if (state.blend) {
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(state.blendSource, state.blendDestination);
+    } else {
+        GLState::disable(GL_BLEND);
+    }
+}
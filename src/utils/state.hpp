@@ -0,0 +1,143 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+    Authors:
+    -------
+
+    Antony Ducommun <nitro@tmsrv.org>
+
+*/
+
+#ifndef __STATE_H_INCLUDE__
+#define __STATE_H_INCLUDE__
+
+
+// fixed function state of a draw, the GL defaults when default constructed
+class RenderState {
+public:
+    bool depthTest;
+    GLenum depthFunc;
+    bool depthWrite;
+    bool cullFace;
+    GLenum cullMode;
+    bool blend;
+    GLenum blendSource;
+    GLenum blendDestination;
+
+
+    inline RenderState() : depthTest(false), depthFunc(GL_LESS), depthWrite(true), cullFace(false), cullMode(GL_BACK), blend(false), blendSource(GL_ONE), blendDestination(GL_ZERO) {
+    }
+
+
+    bool operator == (const RenderState &state) const;
+
+    inline bool operator != (const RenderState &state) const {
+        return !(*this == state);
+    }
+
+
+    static RenderState opaque();
+    static RenderState translucent();
+};
+
+
+// shadow of the bindings of the current context, redundant binds are
+// skipped and unbinds are deferred until something else is bound
+class GLState {
+public:
+    static const GLuint unknown = 0xffffffff;
+
+
+protected:
+    typedef struct {
+        GLuint id;
+        i32u offset;
+        i32u size;
+    } IndexedBinding;
+
+
+    static map<GLenum, GLuint> buffers;
+    static map<pair<GLenum, GLuint>, IndexedBinding> indexedBuffers;
+    static GLuint vertexArray;
+    static GLuint program;
+    static GLuint textureUnit;
+    static vector<map<GLenum, GLuint> > textures;
+    static map<GLenum, GLuint> capabilities;
+    static GLuint depthFunction;
+    static GLuint depthWrite;
+    static GLuint cullMode;
+    static GLuint blendSource;
+    static GLuint blendDestination;
+
+    static i64u issuedCalls;
+    static i64u elidedCalls;
+    static i64u lastIssuedCalls;
+    static i64u lastElidedCalls;
+
+
+    static inline bool update(GLuint &cached, GLuint id) {
+        if (cached == id) {
+            GLState::elidedCalls++;
+            return false;
+        }
+        cached = id;
+        GLState::issuedCalls++;
+        return true;
+    }
+
+    static GLuint & buffer(GLenum target);
+    static GLuint & texture(GLenum target);
+    static GLuint & capability(GLenum cap);
+
+
+public:
+    static bool directStateAccess();
+
+    static void invalidate();
+    static void endFrame();
+
+    static i64u getIssuedCalls();
+    static i64u getElidedCalls();
+
+
+    static void bindBuffer(GLenum target, GLuint id);
+    static void unbindBuffer(GLenum target);
+    static void bindBufferBase(GLenum target, GLuint index, GLuint id);
+    static void bindBufferRange(GLenum target, GLuint index, GLuint id, i32u offset, i32u size);
+    static void deleteBuffer(GLuint id);
+
+    static void bindVertexArray(GLuint id);
+    static void deleteVertexArray(GLuint id);
+
+    static void useProgram(GLuint id);
+    static void releaseProgram();
+    static void deleteProgram(GLuint id);
+
+    static void activeTexture(GLuint unit);
+    static void bindTexture(GLenum target, GLuint id);
+    static void unbindTexture(GLenum target);
+    static void deleteTexture(GLuint id);
+
+    static void enable(GLenum cap);
+    static void disable(GLenum cap);
+    static void depthFunc(GLenum func);
+    static void depthMask(bool write);
+    static void cullFace(GLenum mode);
+    static void blendFunc(GLenum source, GLenum destination);
+    static void applyRenderState(const RenderState &state);
+};
+
+
+#endif //__STATE_H_INCLUDE__
@@ -24,12 +24,17 @@
 
 
 Texture::Texture(GLenum target, GLsizei levels, const GLenum format, GLsizei width, GLsizei height, GLsizei depth) : id(GL_ZERO), enabled(0), target(target), levels(levels), format(format), width(width), height(height), depth(depth) {
+    if (GLState::directStateAccess()) {
+        this->createStorage();
+        return;
+    }
+
     glGenTextures(1, &this->id);
     if (this->id == GL_ZERO) {
         return;
     }
 
-    glBindTexture(this->target, this->id);
+    GLState::bindTexture(this->target, this->id);
     switch (this->target) {
     case GL_TEXTURE_1D:
     // case GL_PROXY_TEXTURE_1D:
@@ -70,15 +75,54 @@ Texture::Texture(GLenum target, GLsizei levels, const GLenum format, GLsizei wid
         fprintf(stderr, "ERROR: Unsupported texture target (%d)\n", this->target);
         break;
     }
-    glBindTexture(this->target, GL_ZERO);
+    GLState::unbindTexture(this->target);
 
     // case GL_TEXTURE_BUFFER:
 
 }
 
+// named creation and storage, the current texture bindings are left alone
+void Texture::createStorage() {
+    glCreateTextures(this->target, 1, &this->id);
+    if (this->id == GL_ZERO) {
+        return;
+    }
+
+    switch (this->target) {
+    case GL_TEXTURE_1D:
+        glTextureStorage1D(this->id, this->levels, this->format, this->width);
+        break;
+
+    case GL_TEXTURE_2D:
+    case GL_TEXTURE_1D_ARRAY:
+    case GL_TEXTURE_RECTANGLE:
+    case GL_TEXTURE_CUBE_MAP:
+        glTextureStorage2D(this->id, this->levels, this->format, this->width, this->height);
+        break;
+
+    case GL_TEXTURE_2D_MULTISAMPLE:
+        glTextureStorage2DMultisample(this->id, this->levels, this->format, this->width, this->height, GL_FALSE);
+        break;
+
+    case GL_TEXTURE_3D:
+    case GL_TEXTURE_2D_ARRAY:
+    case GL_TEXTURE_CUBE_MAP_ARRAY:
+        glTextureStorage3D(this->id, this->levels, this->format, this->width, this->height, this->depth);
+        break;
+
+    case GL_TEXTURE_2D_MULTISAMPLE_ARRAY:
+        glTextureStorage3DMultisample(this->id, this->levels, this->format, this->width, this->height, this->depth, GL_FALSE);
+        break;
+
+    default:
+        fprintf(stderr, "ERROR: Unsupported texture target (%d)\n", this->target);
+        break;
+    }
+}
+
 Texture::~Texture() {
     if (this->id != GL_ZERO) {
-        glDeleteTextures(1, &this->id);
+        GLState::deleteTexture(this->id);
     }
 }
 
@@ -87,14 +131,14 @@ void Texture::enable() {
         if (this->id == GL_ZERO) {
             return;
         }
-        glBindTexture(this->target, this->id);
+        GLState::bindTexture(this->target, this->id);
     }
     this->enabled++;
 }
 void Texture::disable() {
     this->enabled--;
     if (this->enabled == 0) {
-        glBindTexture(this->target, GL_ZERO);
+        GLState::unbindTexture(this->target);
     }
 }
 
@@ -32,6 +32,8 @@ protected:
 
     Texture(GLenum target, GLsizei levels, const GLenum format, GLsizei width, GLsizei height, GLsizei depth);
 
+    void createStorage();
+
 
 public:
     const GLenum target;
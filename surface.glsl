@@ -0,0 +1,4 @@
+// per-surface constants, one slice per draw selected with glBindBufferRange
+layout(std140, row_major) uniform SurfaceConstants {
+    mat4 mMatrix;
+};
@@ -1,8 +1,10 @@
-#version 130
+#version 140
+
+#include "frame.glsl"
+#include "surface.glsl"
 
-uniform mat4 pvmMatrix;
 in vec2 inPosition;
 
 void main(void) {
-    gl_Position = pvmMatrix * vec4(inPosition, 0.0, 1.0);
+    gl_Position = pvMatrix * mMatrix * vec4(inPosition, 0.0, 1.0);
 }